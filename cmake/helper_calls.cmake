@@ -0,0 +1,136 @@
+# Counts the run time helper calls the compiler emitted in target objects, the
+# cost model for the control path on the FPU-less Cortex-M0+. Each call site of
+# an __aeabi helper is found from its relocation in `objdump -dr`, and counted
+# as float, double, 64 bit integer or 32 bit division. The SDK swaps in ROM
+# and hardware divider versions of these at link time, but every one is still
+# a call.
+#
+#   cmake -DOBJDUMP=<objdump> -DOBJECTS=<a.obj|b.obj> -DPATHS=<f|g> -DHOT_PATHS=<f>
+#         -DBEFORE=<f> -DAFTER=<f|g> -DOUTPUT=<csv> -P helper_calls.cmake
+#
+# Writes CSV to OUTPUT:
+# - call sites in each function of the objects that makes a helper call
+# - call sites reachable from each function in PATHS, through direct calls
+#   between functions in the objects, each function counted once
+# - the same for the BEFORE functions against the AFTER functions
+# These are call sites, not calls made at run time, so a helper in a loop
+# counts once. Fails if a HOT_PATHS function reaches a float or double helper.
+
+cmake_minimum_required(VERSION 3.25)
+
+set(helper_categories float double int64 int_div)
+
+function(helper_category symbol result)
+    if(symbol MATCHES "^__aeabi_(d[a-z0-9]+|f2d|u?i2d|u?l2d)$")
+        set(${result} double PARENT_SCOPE)
+    elseif(symbol MATCHES "^__aeabi_(f[a-z0-9]+|u?i2f|u?l2f)$")
+        set(${result} float PARENT_SCOPE)
+    elseif(symbol MATCHES "^__aeabi_(lmul|u?ldivmod|llsl|llsr|lasr|u?lcmp)$")
+        set(${result} int64 PARENT_SCOPE)
+    elseif(symbol MATCHES "^__aeabi_u?idiv(mod)?$")
+        set(${result} int_div PARENT_SCOPE)
+    else()
+        set(${result} "" PARENT_SCOPE)
+    endif()
+endfunction()
+
+string(REPLACE "|" ";" objects "${OBJECTS}")
+string(REPLACE "|" ";" paths "${PATHS}")
+string(REPLACE "|" ";" hot_paths "${HOT_PATHS}")
+string(REPLACE "|" ";" before "${BEFORE}")
+string(REPLACE "|" ";" after "${AFTER}")
+
+# Helper call sites and callees of every function
+set(functions "")
+foreach(object IN LISTS objects)
+    execute_process(COMMAND ${OBJDUMP} -dr ${object} OUTPUT_VARIABLE disassembly RESULT_VARIABLE result)
+    if(NOT 0 EQUAL result)
+        message(FATAL_ERROR "${OBJDUMP} failed on ${object}")
+    endif()
+    string(REPLACE ";" "," disassembly "${disassembly}")
+    string(REPLACE "\n" ";" lines "${disassembly}")
+
+    set(function "")
+    foreach(line IN LISTS lines)
+        if(line MATCHES "^[0-9a-f]+ <([^>]+)>:$")
+            set(function "${CMAKE_MATCH_1}")
+            list(APPEND functions "${function}")
+            set(callees_${function} "")
+            foreach(category IN LISTS helper_categories)
+                set(${category}_${function} 0)
+            endforeach()
+        elseif(function AND line MATCHES "R_ARM_THM_(CALL|JUMP24|JUMP11)[ \t]+([^ \t+]+)")
+            # Calls to static functions may be against their section
+            string(REGEX REPLACE "^\\.text\\." "" callee "${CMAKE_MATCH_2}")
+            helper_category("${callee}" category)
+            if(category)
+                math(EXPR ${category}_${function} "${${category}_${function}} + 1")
+            else()
+                list(APPEND callees_${function} "${callee}")
+            endif()
+        endif()
+    endforeach()
+endforeach()
+
+# Sums the call sites reachable from `roots` into <category>_total in the caller's scope
+function(helper_reachable roots)
+    set(pending ${roots})
+    set(visited "")
+    foreach(category IN LISTS helper_categories)
+        set(${category}_total 0)
+    endforeach()
+    while(pending)
+        list(POP_FRONT pending function)
+        if(function IN_LIST visited OR NOT function IN_LIST functions)
+            continue()
+        endif()
+        list(APPEND visited "${function}")
+        list(APPEND pending ${callees_${function}})
+        foreach(category IN LISTS helper_categories)
+            math(EXPR ${category}_total "${${category}_total} + ${${category}_${function}}")
+        endforeach()
+    endwhile()
+    foreach(category IN LISTS helper_categories)
+        set(${category}_total ${${category}_total} PARENT_SCOPE)
+    endforeach()
+endfunction()
+
+string(JOIN "," header ${helper_categories})
+set(csv "function,${header}\n")
+list(SORT functions)
+list(REMOVE_DUPLICATES functions)
+foreach(function IN LISTS functions)
+    set(row "${function}")
+    set(any 0)
+    foreach(category IN LISTS helper_categories)
+        string(APPEND row ",${${category}_${function}}")
+        math(EXPR any "${any} + ${${category}_${function}}")
+    endforeach()
+    if(any GREATER 0)
+        string(APPEND csv "${row}\n")
+    endif()
+endforeach()
+
+set(failed "")
+string(APPEND csv "\npath,${header}\n")
+foreach(path IN LISTS paths)
+    if(NOT path IN_LIST functions)
+        message(FATAL_ERROR "${path} is not in the objects")
+    endif()
+    helper_reachable("${path}")
+    string(APPEND csv "${path},${float_total},${double_total},${int64_total},${int_div_total}\n")
+    if(path IN_LIST hot_paths AND (float_total GREATER 0 OR double_total GREATER 0))
+        list(APPEND failed "${path}")
+    endif()
+endforeach()
+
+string(APPEND csv "\nreport_path,${header}\n")
+helper_reachable("${before}")
+string(APPEND csv "before,${float_total},${double_total},${int64_total},${int_div_total}\n")
+helper_reachable("${after}")
+string(APPEND csv "after,${float_total},${double_total},${int64_total},${int_div_total}\n")
+
+file(WRITE ${OUTPUT} "${csv}")
+if(failed)
+    message(FATAL_ERROR "Per sample paths reach float or double helpers: ${failed}")
+endif()
@@ -19,7 +19,13 @@ SemaphoreHandle_t config_mutex_handle;
 
 // Config
 #define CONFIG_MAGIC 0x5AD00DAD
-#define CONFIG_CURRENT_VERSION 1
+#define CONFIG_CURRENT_VERSION 8  // 2: Pedal calibration is oversampled to 14 bits
+                                  // 3: Tiller prediction horizon added to control settings
+                                  // 4: Per channel filters added to control settings
+                                  // 5: Response curves added to control settings
+                                  // 6: Auto-tare added to control settings
+                                  // 7: Output backend added to control settings
+                                  // 8: Consumer tick added to control settings
 
 typedef struct config {
     uint32_t magic;
@@ -36,6 +42,11 @@ typedef struct config {
 
 static config_t config;
 
+// Bumped after every change while holding the mutex, read without it so they can
+// be polled. Plain stores as the M0+ has no atomic read-modify-write.
+static uint32_t config_calibration_generation = 0;
+static uint32_t config_control_settings_generation = 0;
+
 config_t* config_in_flash(void) {
     return (config_t*)(XIP_BASE + FLASH_LAST_SECTOR_OFFSET);
 }
@@ -92,6 +103,7 @@ void config_set_calibration(const control_raw_report_t* min, const control_raw_r
     config.calibration_min = *min;
     config.calibration_max = *max;
     config_save_to_flash();
+    __atomic_store_n(&config_calibration_generation, config_calibration_generation + 1, __ATOMIC_RELEASE);
     TANK_ASSERT(pdTRUE == xSemaphoreGive(config_mutex_handle));
 }
 
@@ -113,6 +125,7 @@ void config_set_control_settings(const control_settings_t* settings) {
     config.control_settings_set = true;
     config.control_settings = *settings;
     config_save_to_flash();
+    __atomic_store_n(&config_control_settings_generation, config_control_settings_generation + 1, __ATOMIC_RELEASE);
     TANK_ASSERT(pdTRUE == xSemaphoreGive(config_mutex_handle));
 }
 
@@ -125,4 +138,12 @@ bool config_get_control_settings(control_settings_t* settings) {
     *settings = config.control_settings;
     TANK_ASSERT(pdTRUE == xSemaphoreGive(config_mutex_handle));
     return true;
+}
+
+uint32_t config_get_calibration_generation(void) {
+    return __atomic_load_n(&config_calibration_generation, __ATOMIC_ACQUIRE);
+}
+
+uint32_t config_get_control_settings_generation(void) {
+    return __atomic_load_n(&config_control_settings_generation, __ATOMIC_ACQUIRE);
 }
\ No newline at end of file
@@ -18,4 +18,10 @@ bool config_get_calibration(control_raw_report_t* min, control_raw_report_t* max
 void config_set_control_settings(const control_settings_t* settings);
 
 // Try to get control settings from configuration. Returns true on success, false on error.
-bool config_get_control_settings(control_settings_t* settings);
\ No newline at end of file
+bool config_get_control_settings(control_settings_t* settings);
+
+// Generations change whenever the calibration or control settings are set.
+// Reading one takes no lock, so a task can compare it every cycle and only
+// fetch from the config when it has moved on.
+uint32_t config_get_calibration_generation(void);
+uint32_t config_get_control_settings_generation(void);
\ No newline at end of file
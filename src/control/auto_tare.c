@@ -0,0 +1,59 @@
+#include "auto_tare.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Windows longer than this could overflow the sum of squares
+#define AUTO_TARE_MAX_SAMPLES 4096
+
+void auto_tare_init(auto_tare_t* tare) {
+    tare->window_start_us = 0;
+    tare->count = 0;
+    tare->reference = 0;
+    tare->sum = 0;
+    tare->sum_of_squares = 0;
+}
+
+bool auto_tare_add(auto_tare_t* tare,
+                   const auto_tare_settings_t* settings,
+                   int32_t sample,
+                   bool at_rest,
+                   int32_t zero,
+                   uint32_t timestamp_us,
+                   int32_t* correction) {
+    if (0 == settings->window_us || !at_rest) {
+        tare->count = 0;
+        return false;
+    }
+
+    // Start a window
+    if (0 == tare->count) {
+        tare->window_start_us = timestamp_us;
+        tare->reference = sample;
+        tare->sum = 0;
+        tare->sum_of_squares = 0;
+    }
+
+    // Accumulate
+    const int64_t offset = (int64_t)sample - tare->reference;
+    tare->count++;
+    tare->sum += offset;
+    tare->sum_of_squares += offset * offset;
+    if (timestamp_us - tare->window_start_us < settings->window_us && tare->count < AUTO_TARE_MAX_SAMPLES) {
+        return false;
+    }
+
+    // The window is complete, move the zero only if the cell was steady
+    const int64_t count = tare->count;
+    const int64_t mean_offset = tare->sum / count;
+    const int64_t variance = (tare->sum_of_squares - mean_offset * tare->sum) / count;
+    const int64_t max_variance = (int64_t)settings->max_deviation * settings->max_deviation;
+    tare->count = 0;
+    if (variance > max_variance) {
+        return false;
+    }
+
+    const int64_t error = tare->reference + mean_offset - zero;
+    *correction = (int32_t)((error * settings->correction_q16) / 65536);
+    return 0 != *correction;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Tracks the resting value of a load cell so its zero can follow drift from
+// temperature and creep. Samples are collected while the cell is at rest, and
+// once it has rested steadily for a whole window the zero is moved part of the
+// way towards the mean of that window. Each sample is O(1).
+
+typedef struct auto_tare_settings {
+    uint32_t window_us;       // How long the cell must rest before its zero moves. 0 disables auto-tare
+    uint32_t max_deviation;   // Largest standard deviation over the window, in raw units, that counts as resting
+    uint32_t correction_q16;  // Fraction of the difference between the zero and the mean corrected per window
+} auto_tare_settings_t;
+
+typedef struct auto_tare {
+    uint32_t window_start_us;
+    uint32_t count;
+    int32_t reference;  // First sample of the window, statistics are relative to it to keep them small
+    int64_t sum;
+    int64_t sum_of_squares;
+} auto_tare_t;
+
+void auto_tare_init(auto_tare_t* tare);
+
+// Adds a sample taken at `timestamp_us`. `at_rest` is whether the cell is
+// unloaded, any loaded sample restarts the window. Returns true and sets
+// `correction`, to be added to the zero, when the zero should move.
+bool auto_tare_add(auto_tare_t* tare,
+                   const auto_tare_settings_t* settings,
+                   int32_t sample,
+                   bool at_rest,
+                   int32_t zero,
+                   uint32_t timestamp_us,
+                   int32_t* correction);
@@ -1,5 +1,6 @@
 #include "control_map.h"
 
+#include <stddef.h>
 #include <stdio.h>
 #include "util/helpers.h"
 #include "util/tank_assert.h"
@@ -17,71 +18,206 @@ const char* input_gear_to_str(input_gear_t gear) {
 
 void input_report_print(const input_report_t* report) {
     printf("{\r\n");
-    printf("  \"left_tiller\": %f,\r\n", report->left_tiller);
-    printf("  \"right_tiller\": %f,\r\n", report->right_tiller);
-    printf("  \"accelerator\": %f,\r\n", report->accelerator);
+    printf("  \"left_tiller\": %f,\r\n", q16_to_float(report->left_tiller));
+    printf("  \"right_tiller\": %f,\r\n", q16_to_float(report->right_tiller));
+    printf("  \"accelerator\": %f,\r\n", q16_to_float(report->accelerator));
     printf("  \"gear\": %s\r\n", input_gear_to_str(report->gear));
     printf("}\r\n");
 }
 
-typedef struct tiller_output {
-    float side_pwm;
-    float handbrake_pwm;
-} tiller_output_t;
+void control_ramp_init(control_ramp_t* ramp, int32_t from, int32_t to, q16_t empty_value) {
+    ramp->from = from;
+    const int64_t span = (int64_t)to - from;
+    if (0 == span) {
+        ramp->scale = 0;
+        ramp->shift = 1;
+        ramp->base = empty_value;
+        return;
+    }
 
-tiller_output_t map_tiller_input_to_output(const control_settings_t* config, const float tiller_input) {
-    tiller_output_t output = {.side_pwm = 0.0, .handbrake_pwm = 0.0};
+    // Pick the shift that puts the magnitude of the reciprocal in (2^29, 2^30]
+    const uint64_t magnitude = span < 0 ? -span : span;
+    ramp->shift = (uint8_t)(14 + (63 - __builtin_clzll(magnitude)));
+    const int64_t one = (int64_t)1 << (Q16_FRACTIONAL_BITS + ramp->shift);
+    const int64_t reciprocal = (one + (int64_t)(magnitude / 2)) / (int64_t)magnitude;
+    ramp->scale = (int32_t)(span < 0 ? -reciprocal : reciprocal);
+    ramp->base = Q16_ZERO;
+}
 
-    // Apply deadzone
-    if (tiller_input < config->tiller_deadzone) {
-        return output;
-    }
+void control_transform_build(control_transform_t* transform,
+                             const control_settings_t* settings,
+                             const control_raw_report_t* calibration_min,
+                             const control_raw_report_t* calibration_max) {
+    // High raw pedal values indicate that the pedal is not depressed
+    control_ramp_init(&transform->accelerator, calibration_max->accelerator, calibration_min->accelerator, Q16_ONE);
+    control_ramp_init(&transform->brake, calibration_max->brake, calibration_min->brake, Q16_ONE);
+    control_ramp_init(&transform->left_tiller, calibration_min->left_tiller, calibration_max->left_tiller, Q16_ZERO);
+    control_ramp_init(&transform->right_tiller, calibration_min->right_tiller, calibration_max->right_tiller,
+                      Q16_ZERO);
+
+    // Turning is on the range from the deadzone to the max turn threshold.
+    // An empty or inverted range is a step at its start.
+    transform->pedal_deadzone = q16_from_float(settings->pedal_deadzone);
+    transform->tiller_deadzone = q16_from_float(settings->tiller_deadzone);
+    transform->tiller_handbrake_threshold_begin = q16_from_float(settings->tiller_handbrake_threshold_begin);
+    const q16_t max_turn = q16_from_float(settings->tiller_max_turn_threshold);
+    const q16_t handbrake_end = q16_from_float(settings->tiller_handbrake_threshold_end);
+    control_ramp_init(&transform->pedal, transform->pedal_deadzone, Q16_ONE, Q16_ONE);
+    control_ramp_init(&transform->tiller_turn, transform->tiller_deadzone,
+                      MAX_OF(max_turn, transform->tiller_deadzone), Q16_ONE);
+    control_ramp_init(&transform->tiller_handbrake, transform->tiller_handbrake_threshold_begin,
+                      MAX_OF(handbrake_end, transform->tiller_handbrake_threshold_begin), Q16_ONE);
+
+    // Curves shape the ramps
+    response_curve_build(&transform->pedal_curve, &settings->pedal_response_curve);
+    response_curve_build(&transform->tiller_curve, &settings->tiller_response_curve);
+}
+
+static control_transform_t control_transforms[2];
+static const control_transform_t* control_transform_active = NULL;
+
+void control_transform_update(const control_settings_t* settings,
+                              const control_raw_report_t* calibration_min,
+                              const control_raw_report_t* calibration_max) {
+    control_transform_t* inactive =
+        (control_transform_active == &control_transforms[0]) ? &control_transforms[1] : &control_transforms[0];
+    control_transform_build(inactive, settings, calibration_min, calibration_max);
+    __atomic_store_n(&control_transform_active, inactive, __ATOMIC_RELEASE);
+}
 
-    // Apply turning
-    // Turning is on the range from the deadzone to the max turn threshold
-    output.side_pwm =
-        (tiller_input - config->tiller_deadzone) / (config->tiller_max_turn_threshold - config->tiller_deadzone);
-    output.side_pwm = MIN_OF(output.side_pwm, 1.0);
-
-    // Apply hand brake
-    if (tiller_input > config->tiller_handbrake_threshold_begin) {
-        output.handbrake_pwm = (tiller_input - config->tiller_handbrake_threshold_begin) /
-                               (config->tiller_handbrake_threshold_end - config->tiller_handbrake_threshold_begin);
-        output.handbrake_pwm = MIN_OF(output.handbrake_pwm, 1.0);
+const control_transform_t* control_transform_get(void) {
+    return __atomic_load_n(&control_transform_active, __ATOMIC_ACQUIRE);
+}
+
+// Batch bodies are inline so the single sample wrappers fold to straight line code
+static inline void input_make_report_batch_impl(const control_transform_t* transform,
+                                                const control_raw_batch_t* raw,
+                                                size_t n,
+                                                const input_report_batch_t* reports) {
+    const int16_t* restrict accelerator = raw->accelerator;
+    const int32_t* restrict left_tiller = raw->left_tiller;
+    const int32_t* restrict right_tiller = raw->right_tiller;
+    q16_t* restrict accelerator_out = reports->accelerator;
+    q16_t* restrict left_tiller_out = reports->left_tiller;
+    q16_t* restrict right_tiller_out = reports->right_tiller;
+
+    // One channel per loop, with the ramps copied out so they stay in registers
+    const control_ramp_t accelerator_ramp = transform->accelerator;
+    const control_ramp_t left_tiller_ramp = transform->left_tiller;
+    const control_ramp_t right_tiller_ramp = transform->right_tiller;
+    for (size_t i = 0; i < n; i++) {
+        accelerator_out[i] = control_ramp_apply(&accelerator_ramp, accelerator[i]);
+    }
+    for (size_t i = 0; i < n; i++) {
+        left_tiller_out[i] = control_ramp_apply(&left_tiller_ramp, left_tiller[i]);
+    }
+    for (size_t i = 0; i < n; i++) {
+        right_tiller_out[i] = control_ramp_apply(&right_tiller_ramp, right_tiller[i]);
     }
+}
 
-    return output;
+void input_make_report_batch(const control_transform_t* transform,
+                             const control_raw_batch_t* raw,
+                             size_t n,
+                             const input_report_batch_t* reports) {
+    input_make_report_batch_impl(transform, raw, n, reports);
+}
+
+input_report_t input_make_report(const control_transform_t* transform,
+                                 const control_raw_report_t* current,
+                                 const control_raw_timestamps_t* timestamps) {
+    input_report_t report = {// TODO gear selection
+                             .gear = INPUT_FORWARDS,
+                             .pedal_timestamp_us = timestamps->pedals_us,
+                             .tiller_timestamp_us = timestamps->tillers_us};
+
+    const control_raw_batch_t raw = {.accelerator = &current->accelerator,
+                                     .left_tiller = &current->left_tiller,
+                                     .right_tiller = &current->right_tiller};
+    const input_report_batch_t reports = {
+        .accelerator = &report.accelerator, .left_tiller = &report.left_tiller, .right_tiller = &report.right_tiller};
+    input_make_report_batch_impl(transform, &raw, 1, &reports);
+
+    return report;
 }
 
-typedef struct pedal_output {
-    float pwm;
-} pedal_output_t;
+// Turning from a tiller, zero in the deadzone
+static inline q16_t map_tiller_to_side(const control_transform_t* transform, q16_t tiller_input) {
+    const q16_t side =
+        response_curve_apply(&transform->tiller_curve, control_ramp_apply(&transform->tiller_turn, tiller_input));
+    return tiller_input < transform->tiller_deadzone ? Q16_ZERO : side;
+}
 
-pedal_output_t map_pedal_input_to_output(const control_settings_t* config, const float pedal_input) {
-    pedal_output_t output = {.pwm = 0.0};
+// Hand brake from a tiller, zero in the deadzone and up to the hand brake threshold
+static inline q16_t map_tiller_to_handbrake(const control_transform_t* transform, q16_t tiller_input) {
+    const q16_t handbrake = control_ramp_apply(&transform->tiller_handbrake, tiller_input);
+    const bool applied =
+        tiller_input >= transform->tiller_deadzone && tiller_input > transform->tiller_handbrake_threshold_begin;
+    return applied ? handbrake : Q16_ZERO;
+}
 
-    // Apply dead zone
-    if (pedal_input < config->pedal_deadzone) {
-        return output;
-    }
+// Pedal application, zero in the dead zone
+static inline q16_t map_pedal_to_pwm(const control_transform_t* transform, q16_t pedal_input) {
+    const q16_t pwm = response_curve_apply(&transform->pedal_curve, control_ramp_apply(&transform->pedal, pedal_input));
+    return pedal_input < transform->pedal_deadzone ? Q16_ZERO : pwm;
+}
 
-    // Apply pedal
-    output.pwm = (pedal_input - config->pedal_deadzone) / (1.0 - config->pedal_deadzone);
-    output.pwm = MIN_OF(output.pwm, 1.0);
+static inline void map_input_to_output_batch_impl(const control_transform_t* transform,
+                                                  const input_report_batch_t* reports,
+                                                  size_t n,
+                                                  const keyboard_output_batch_t* outputs) {
+    const q16_t* restrict accelerator = reports->accelerator;
+    const q16_t* restrict left_tiller = reports->left_tiller;
+    const q16_t* restrict right_tiller = reports->right_tiller;
+    q16_t* restrict forward = outputs->forward_duty_cycle;
+    q16_t* restrict left = outputs->left_duty_cycle;
+    q16_t* restrict right = outputs->right_duty_cycle;
+    q16_t* restrict reverse = outputs->reverse_duty_cycle;
+    q16_t* restrict hand_brake = outputs->hand_brake_duty_cycle;
+
+    for (size_t i = 0; i < n; i++) {
+        forward[i] = map_pedal_to_pwm(transform, accelerator[i]);
+    }
+    for (size_t i = 0; i < n; i++) {
+        left[i] = map_tiller_to_side(transform, left_tiller[i]);
+    }
+    for (size_t i = 0; i < n; i++) {
+        right[i] = map_tiller_to_side(transform, right_tiller[i]);
+    }
+    for (size_t i = 0; i < n; i++) {
+        const q16_t left_handbrake = map_tiller_to_handbrake(transform, left_tiller[i]);
+        const q16_t right_handbrake = map_tiller_to_handbrake(transform, right_tiller[i]);
+        hand_brake[i] = MAX_OF(left_handbrake, right_handbrake);
+    }
 
-    return output;
+    // Reverse is not mapped, see CONTROL_MAP_REVERSE_CHANNELS
+    for (size_t i = 0; i < n; i++) {
+        reverse[i] = Q16_ZERO;
+    }
 }
 
-keyboard_output_t map_input_to_output(const control_settings_t* config, const input_report_t* input) {
-    const pedal_output_t accelerator = map_pedal_input_to_output(config, input->accelerator);
-    const tiller_output_t left_tiller = map_tiller_input_to_output(config, input->left_tiller);
-    const tiller_output_t right_tiller = map_tiller_input_to_output(config, input->right_tiller);
+void map_input_to_output_batch(const control_transform_t* transform,
+                               const input_report_batch_t* reports,
+                               size_t n,
+                               const keyboard_output_batch_t* outputs) {
+    map_input_to_output_batch_impl(transform, reports, n, outputs);
+}
 
-    // TODO reverse
-    keyboard_output_t output = {.forward_duty_cycle = accelerator.pwm,
-                                .left_duty_cycle = left_tiller.side_pwm,
-                                .right_duty_cycle = right_tiller.side_pwm,
-                                .hand_brake_duty_cycle = MAX_OF(left_tiller.handbrake_pwm, right_tiller.handbrake_pwm)};
+keyboard_output_t map_input_to_output(const control_transform_t* transform, const input_report_t* input) {
+    keyboard_output_t output;
+    const input_report_batch_t reports = {.accelerator = (q16_t*)&input->accelerator,
+                                          .left_tiller = (q16_t*)&input->left_tiller,
+                                          .right_tiller = (q16_t*)&input->right_tiller};
+    const keyboard_output_batch_t outputs = {.forward_duty_cycle = &output.forward_duty_cycle,
+                                             .left_duty_cycle = &output.left_duty_cycle,
+                                             .right_duty_cycle = &output.right_duty_cycle,
+                                             .reverse_duty_cycle = &output.reverse_duty_cycle,
+                                             .hand_brake_duty_cycle = &output.hand_brake_duty_cycle};
+    map_input_to_output_batch_impl(transform, &reports, 1, &outputs);
 
     return output;
 }
+
+q16_t map_brake(const control_transform_t* transform, int16_t raw_brake) {
+    return map_pedal_to_pwm(transform, control_ramp_apply(&transform->brake, raw_brake));
+}
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "response_curve.h"
 #include "types.h"
 #include "usb_keyboard/types.h"
+#include "util/fixed.h"
 
 typedef enum input_gear {
     INPUT_FORWARDS,
@@ -12,14 +15,129 @@ typedef enum input_gear {
 } input_gear_t;
 
 typedef struct input_report {
-    float left_tiller;   // Bound between 0.0 and 1.0
-    float right_tiller;  // Bound between 0.0 and 1.0
-    float accelerator;   // Bound between 0.0 and 1.0
+    q16_t left_tiller;   // Bound between Q16_ZERO and Q16_ONE
+    q16_t right_tiller;  // Bound between Q16_ZERO and Q16_ONE
+    q16_t accelerator;   // Bound between Q16_ZERO and Q16_ONE
     input_gear_t gear;
+
+    // When the raw values behind the report were acquired, see time_us_32()
+    uint32_t pedal_timestamp_us;
+    uint32_t tiller_timestamp_us;
 } input_report_t;
 
+// Maps `from`..`to` onto Q16_ZERO..Q16_ONE by multiplying with a precomputed
+// reciprocal, clamping outside the range. `to` may be below `from`.
+typedef struct control_ramp {
+    int32_t from;
+    int32_t scale;  // Q16 per input unit, scaled up by 2^shift. Negative when `to` is below `from`
+    uint8_t shift;  // At least 1
+    q16_t base;  // Output at `from`, or everywhere if the range is empty
+} control_ramp_t;
+
+// Everything needed to go from raw sensor values to duty cycles, compiled from
+// the calibration and control settings so the per cycle path has no divisions.
+typedef struct control_transform {
+    // Raw to report
+    control_ramp_t accelerator;
+    control_ramp_t left_tiller;
+    control_ramp_t right_tiller;
+    control_ramp_t brake;
+
+    // Report to output
+    q16_t pedal_deadzone;
+    q16_t tiller_deadzone;
+    q16_t tiller_handbrake_threshold_begin;
+    control_ramp_t pedal;
+    control_ramp_t tiller_turn;
+    control_ramp_t tiller_handbrake;
+    response_curve_t pedal_curve;
+    response_curve_t tiller_curve;
+} control_transform_t;
+
 const char* input_gear_to_str(input_gear_t gear);
 
 void input_report_print(const input_report_t* report);
 
-keyboard_output_t map_input_to_output(const control_settings_t* config, const input_report_t* input);
+void control_ramp_init(control_ramp_t* ramp, int32_t from, int32_t to, q16_t empty_value);
+
+static inline q16_t control_ramp_apply(const control_ramp_t* ramp, int32_t value) {
+    const int64_t product = ((int64_t)value - ramp->from) * ramp->scale;
+    const int64_t result = ramp->base + ((product + ((int64_t)1 << (ramp->shift - 1))) >> ramp->shift);
+    return (q16_t)(result < Q16_ZERO ? Q16_ZERO : (result > Q16_ONE ? Q16_ONE : result));
+}
+
+void control_transform_build(control_transform_t* transform,
+                             const control_settings_t* settings,
+                             const control_raw_report_t* calibration_min,
+                             const control_raw_report_t* calibration_max);
+
+// The cached transform is double buffered. An update builds into the inactive
+// copy and then swaps it in, so a reader always sees a complete transform.
+// There must only be one task updating it.
+void control_transform_update(const control_settings_t* settings,
+                              const control_raw_report_t* calibration_min,
+                              const control_raw_report_t* calibration_max);
+
+// Returns the current transform, or NULL before the first update
+const control_transform_t* control_transform_get(void);
+
+// Structure of arrays views for mapping many samples at once, element i of
+// every array belongs to sample i
+typedef struct control_raw_batch {
+    const int16_t* accelerator;
+    const int32_t* left_tiller;
+    const int32_t* right_tiller;
+} control_raw_batch_t;
+
+typedef struct input_report_batch {
+    q16_t* accelerator;
+    q16_t* left_tiller;
+    q16_t* right_tiller;
+} input_report_batch_t;
+
+typedef struct keyboard_output_batch {
+    q16_t* forward_duty_cycle;
+    q16_t* left_duty_cycle;
+    q16_t* right_duty_cycle;
+    q16_t* reverse_duty_cycle;
+    q16_t* hand_brake_duty_cycle;
+} keyboard_output_batch_t;
+
+// Scales `n` raw samples into reports. The single sample functions below wrap
+// these, so both always give the same result.
+void input_make_report_batch(const control_transform_t* transform,
+                             const control_raw_batch_t* raw,
+                             size_t n,
+                             const input_report_batch_t* reports);
+
+// Maps `n` reports to duty cycles, reports are read through `reports` only
+void map_input_to_output_batch(const control_transform_t* transform,
+                               const input_report_batch_t* reports,
+                               size_t n,
+                               const keyboard_output_batch_t* outputs);
+
+// Scales the raw sensor values into an input report using the calibrated range
+input_report_t input_make_report(const control_transform_t* transform,
+                                 const control_raw_report_t* current,
+                                 const control_raw_timestamps_t* timestamps);
+
+keyboard_output_t map_input_to_output(const control_transform_t* transform, const input_report_t* input);
+
+// Brake pedal application, shaped like the accelerator's. Only the gamepad has
+// a brake, the keyboard output has no key for it.
+q16_t map_brake(const control_transform_t* transform, int16_t raw_brake);
+
+// Raw channels each output of map_input_to_output() is computed from. Channels
+// outside CONTROL_MAP_CHANNELS do not need to be acquired at the control rate.
+// Reverse is not mapped, it is always released and reads no channel.
+#define CONTROL_MAP_FORWARD_CHANNELS CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_ACCELERATOR)
+#define CONTROL_MAP_LEFT_CHANNELS CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_LEFT_TILLER)
+#define CONTROL_MAP_RIGHT_CHANNELS CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_RIGHT_TILLER)
+#define CONTROL_MAP_REVERSE_CHANNELS ((control_raw_channel_mask_t)0)
+#define CONTROL_MAP_HAND_BRAKE_CHANNELS (CONTROL_MAP_LEFT_CHANNELS | CONTROL_MAP_RIGHT_CHANNELS)
+#define CONTROL_MAP_CHANNELS                                                                 \
+    (CONTROL_MAP_FORWARD_CHANNELS | CONTROL_MAP_LEFT_CHANNELS | CONTROL_MAP_RIGHT_CHANNELS | \
+     CONTROL_MAP_REVERSE_CHANNELS | CONTROL_MAP_HAND_BRAKE_CHANNELS)
+
+// Raw channels map_brake() is computed from
+#define CONTROL_MAP_BRAKE_CHANNELS CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_BRAKE)
@@ -0,0 +1,14 @@
+#include "control_pipeline.hpp"
+
+#include "control_pipeline.h"
+
+static_assert(control_pipeline::firmware::channels == CONTROL_MAP_CHANNELS,
+              "The firmware profile must read the same channels as map_input_to_output()");
+
+keyboard_output_t control_pipeline_run(const control_transform_t* transform, const control_raw_report_t* raw) {
+    return control_pipeline::firmware::run(*transform, *raw);
+}
+
+control_raw_channel_mask_t control_pipeline_channels(void) {
+    return control_pipeline::firmware::channels;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "control_map.h"
+#include "types.h"
+#include "usb_keyboard/types.h"
+
+// Raw sensor values to keyboard output through the firmware profile of the
+// compile time pipeline in control_pipeline.hpp. Gives the same result as
+// input_make_report() followed by map_input_to_output().
+keyboard_output_t control_pipeline_run(const control_transform_t* transform, const control_raw_report_t* raw);
+
+// Raw channels control_pipeline_run() reads, the rest need not be acquired for it
+control_raw_channel_mask_t control_pipeline_channels(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,134 @@
+#pragma once
+
+// Compile time composable control pipeline.
+//
+// Each stage is a policy with a static `apply(transform, value)`, and a chain
+// of stages is a type. Every stage is known at compile time, so the compiler
+// can inline the whole chain for a profile and fold away stages that do
+// nothing. The stages are the same operations control_map.c uses, so a
+// profile built from them matches it exactly.
+
+#include <cstdint>
+
+extern "C" {
+#include "control/control_map.h"
+#include "control/response_curve.h"
+#include "util/filter.h"
+#include "util/helpers.h"
+}
+
+namespace control_pipeline {
+
+// Raw sensor value to Q16 using the calibrated range
+template <control_ramp_t control_transform_t::*Ramp>
+struct calibrate {
+    static int32_t apply(const control_transform_t& transform, int32_t raw) {
+        return control_ramp_apply(&(transform.*Ramp), raw);
+    }
+};
+
+// Runs a filter with static storage, for profiles that filter at the pipeline rate
+template <filter_t* Filter>
+struct filter {
+    static int32_t apply(const control_transform_t&, int32_t value) { return filter_apply(Filter, value); }
+};
+
+template <control_ramp_t control_transform_t::*Ramp>
+struct ramp {
+    static int32_t apply(const control_transform_t& transform, int32_t value) {
+        return control_ramp_apply(&(transform.*Ramp), value);
+    }
+};
+
+// Zero below the deadzone, otherwise the stages that follow. The zero is not
+// passed on, so a curve that lifts zero cannot press a released pedal.
+template <q16_t control_transform_t::*Deadzone, typename Then>
+struct deadzone {
+    static int32_t apply(const control_transform_t& transform, int32_t value) {
+        if (value < transform.*Deadzone) {
+            return Q16_ZERO;
+        }
+        return Then::apply(transform, value);
+    }
+};
+
+// Zero at or below the threshold, otherwise the ramp from the threshold
+template <q16_t control_transform_t::*Threshold, control_ramp_t control_transform_t::*Ramp>
+struct above {
+    static int32_t apply(const control_transform_t& transform, int32_t value) {
+        if (value <= transform.*Threshold) {
+            return Q16_ZERO;
+        }
+        return control_ramp_apply(&(transform.*Ramp), value);
+    }
+};
+
+template <response_curve_t control_transform_t::*Curve>
+struct curve {
+    static int32_t apply(const control_transform_t& transform, int32_t value) {
+        return response_curve_apply(&(transform.*Curve), value);
+    }
+};
+
+// Stages applied in order
+template <typename... Stages>
+struct chain {
+    static int32_t apply(const control_transform_t& transform, int32_t value) {
+        ((value = Stages::apply(transform, value)), ...);
+        return value;
+    }
+};
+
+// A tiller drives both turning and the handbrake from the same report value,
+// neither applies below the deadzone
+template <q16_t control_transform_t::*Deadzone, typename Turn, typename Handbrake>
+struct handbrake_split {
+    struct output {
+        q16_t turn;
+        q16_t handbrake;
+    };
+
+    static output apply(const control_transform_t& transform, q16_t tiller) {
+        if (tiller < transform.*Deadzone) {
+            return {Q16_ZERO, Q16_ZERO};
+        }
+        return {Turn::apply(transform, tiller), Handbrake::apply(transform, tiller)};
+    }
+};
+
+// Raw report to keyboard output
+template <typename Accelerator, typename LeftTiller, typename RightTiller, typename Tiller>
+struct pipeline {
+    // Raw channels the profile reads
+    static constexpr control_raw_channel_mask_t channels = CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_ACCELERATOR) |
+                                                           CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_LEFT_TILLER) |
+                                                           CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_RIGHT_TILLER);
+
+    static keyboard_output_t run(const control_transform_t& transform, const control_raw_report_t& raw) {
+        const auto left = Tiller::apply(transform, LeftTiller::apply(transform, raw.left_tiller));
+        const auto right = Tiller::apply(transform, RightTiller::apply(transform, raw.right_tiller));
+
+        keyboard_output_t output = {};
+        output.forward_duty_cycle = Accelerator::apply(transform, raw.accelerator);
+        output.left_duty_cycle = left.turn;
+        output.right_duty_cycle = right.turn;
+        output.reverse_duty_cycle = Q16_ZERO;  // Not mapped, no input selects reverse
+        output.hand_brake_duty_cycle = MAX_OF(left.handbrake, right.handbrake);
+        return output;
+    }
+};
+
+// The firmware profile, the same chain as input_make_report() then
+// map_input_to_output(). Like them it does not map reverse, which stays released.
+using firmware = pipeline<
+    chain<calibrate<&control_transform_t::accelerator>,
+          deadzone<&control_transform_t::pedal_deadzone,
+                   chain<ramp<&control_transform_t::pedal>, curve<&control_transform_t::pedal_curve>>>>,
+    chain<calibrate<&control_transform_t::left_tiller>>,
+    chain<calibrate<&control_transform_t::right_tiller>>,
+    handbrake_split<&control_transform_t::tiller_deadzone,
+                    chain<ramp<&control_transform_t::tiller_turn>, curve<&control_transform_t::tiller_curve>>,
+                    chain<above<&control_transform_t::tiller_handbrake_threshold_begin,
+                                &control_transform_t::tiller_handbrake>>>>;
+
+}  // namespace control_pipeline
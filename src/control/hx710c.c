@@ -1,45 +1,56 @@
 #include <hardware/gpio.h>
+#include <hardware/irq.h>
 #include <pico/time.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "hx710c.h"
-
-// Delay approximately 150ns (close enough for government work)
-__attribute__((always_inline)) static inline void hx710c_delay_150ns() {
-    asm volatile(
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n"
-        "nop\n");
-}
-
-// Delay approximately 300ns (close enough for government work)
-__attribute__((always_inline)) static inline void hx710c_delay_300ns() {
-    hx710c_delay_150ns();
-    hx710c_delay_150ns();
+#include "hx710c_pio.h"
+#include "util/bit_transpose.h"
+#include "util/tank_assert.h"
+#include "util/timing.h"
+
+// Device notified by the DRDY interrupt
+static hx710c_t* hx710c_irq_device = NULL;
+
+// Timings from the HX710C datasheet
+#define HX710C_T1_MIN_NS 100  // DOUT falling to the first SCL rising edge
+#define HX710C_T2_MAX_NS 100  // SCL rising edge to DOUT valid
+#define HX710C_T3_MIN_NS 200  // SCL high
+#define HX710C_T4_MIN_NS 200  // SCL low
+
+// The above in clk_sys cycles, set by hx710c_init_timing()
+static struct {
+    uint32_t t1;
+    uint32_t t2;
+    uint32_t t3;
+    uint32_t t3_after_t2;  // What is left of T3 once DOUT has been sampled
+    uint32_t t4;
+} hx710c_delay_cycles;
+
+static void hx710c_init_timing(void) {
+    hx710c_delay_cycles.t1 = timing_ns_to_cycles(HX710C_T1_MIN_NS);
+    hx710c_delay_cycles.t2 = timing_ns_to_cycles(HX710C_T2_MAX_NS);
+    hx710c_delay_cycles.t3 = timing_ns_to_cycles(HX710C_T3_MIN_NS);
+    hx710c_delay_cycles.t3_after_t2 = timing_ns_to_cycles(HX710C_T3_MIN_NS - HX710C_T2_MAX_NS);
+    hx710c_delay_cycles.t4 = timing_ns_to_cycles(HX710C_T4_MIN_NS);
 }
 
-void hx710c_init(hx710c_t* const device, const uint8_t scl_pin, const uint8_t* const sda_pins,
-                 const uint8_t n_sda_pins) {
+static void hx710c_init_pins(hx710c_t* const device, const uint8_t scl_pin, const uint8_t* const sda_pins,
+                             const uint8_t n_sda_pins) {
     // Fill struct
     device->n_sda_pins = n_sda_pins;
     device->scl_pin = scl_pin;
     device->sda_pins = sda_pins;
+    device->pio_engine = NULL;
+    device->ready_callback = NULL;
+    device->ready_callback_context = NULL;
+    device->n_ready = 0;
+    device->n_ready_read = 0;
+    device->missed_conversions = 0;
+
+    // Bus timing depends on clk_sys
+    hx710c_init_timing();
 
     // Init SCL
     gpio_init(scl_pin);
@@ -47,56 +58,110 @@ void hx710c_init(hx710c_t* const device, const uint8_t scl_pin, const uint8_t* c
     gpio_set_dir(scl_pin, true);
 
     // Init SDA pins
+    device->sda_mask = 0;
     for (uint8_t i = 0; i < n_sda_pins; i++) {
         gpio_init(sda_pins[i]);
         gpio_disable_pulls(sda_pins[i]);
         gpio_set_dir(sda_pins[i], false);
+        device->sda_mask |= 1u << sda_pins[i];
     }
+}
+
+void hx710c_init(hx710c_t* const device, const uint8_t scl_pin, const uint8_t* const sda_pins,
+                 const uint8_t n_sda_pins) {
+    hx710c_init_pins(device, scl_pin, sda_pins, n_sda_pins);
 
     // Select 40hz sample rate
     gpio_put(scl_pin, false);
-    hx710c_delay_150ns();  // T1
+    timing_delay_cycles(hx710c_delay_cycles.t1);  // T1
 
     const uint8_t n_pulses_for_40hz = 27;
     for (uint8_t i = 0; i < n_pulses_for_40hz; i++) {
         gpio_put(scl_pin, true);
-        hx710c_delay_300ns();  // T3
+        timing_delay_cycles(hx710c_delay_cycles.t3);  // T3
         gpio_put(scl_pin, false);
-        hx710c_delay_300ns();  // T4
+        timing_delay_cycles(hx710c_delay_cycles.t4);  // T4
     }
 }
 
-bool hx710c_read(hx710c_t* device, int32_t* conversions) {
-    // Check ready
-    if (!hx710c_is_ready(device)) {
-        return false;
+void hx710c_init_pio(hx710c_t* const device, const PIO pio, const uint8_t scl_pin, const uint8_t* const sda_pins,
+                     const uint8_t n_sda_pins) {
+    hx710c_init_pins(device, scl_pin, sda_pins, n_sda_pins);
+
+    // The state machine samples every SDA pin with a single IN instruction
+    for (uint8_t i = 1; i < n_sda_pins; i++) {
+        TANK_ASSERT_M(sda_pins[i] == sda_pins[0] + i, "HX710C SDA pins must be consecutive for PIO");
     }
 
-    // Init conversions
-    memset(conversions, 0, device->n_sda_pins * sizeof(uint32_t));
-    uint32_t* conversions_u32 = (uint32_t*)conversions;
+    // The state machine selects 40hz mode with every conversion it reads
+    device->pio_engine = hx710c_pio_start(pio, scl_pin, sda_pins[0], n_sda_pins);
+}
+
+// Bit-bangs a conversion out of the devices
+static void hx710c_read_gpio(hx710c_t* device, uint32_t* conversions_u32) {
+    // DOUT toggles with the data, hold off the DRDY interrupt until it idles high again
+    const bool drdy_irq_enabled = NULL != device->ready_callback;
+    if (drdy_irq_enabled) {
+        gpio_set_irq_enabled(device->sda_pins[0], GPIO_IRQ_EDGE_FALL, false);
+    }
 
     // Ensure T1 timing
-    hx710c_delay_150ns();
+    timing_delay_cycles(hx710c_delay_cycles.t1);
 
-    // Read conversion
+    // Read conversion. Every SDA pin is sampled with a single read per clock,
+    // so the SCL high time does not grow with the number of devices.
+    // bit_planes[n] holds bit n of every device, at the position of its SDA pin.
+    const uint32_t sda_mask = device->sda_mask;
+    uint32_t bit_planes[32] = {0};
     for (int8_t bit = 23; bit > -1; bit--) {
         gpio_put(device->scl_pin, true);
-        hx710c_delay_150ns();  // T2
-        for (uint8_t i = 0; i < device->n_sda_pins; i++) {
-            conversions_u32[i] |= ((uint32_t)gpio_get(device->sda_pins[i])) << bit;
-        }
-        hx710c_delay_300ns();  // T3
+        timing_delay_cycles(hx710c_delay_cycles.t2);  // T2
+        bit_planes[bit] = gpio_get_all() & sda_mask;
+        timing_delay_cycles(hx710c_delay_cycles.t3_after_t2);  // T3
         gpio_put(device->scl_pin, false);
-        hx710c_delay_300ns();  // T4
+        timing_delay_cycles(hx710c_delay_cycles.t4);  // T4
     }
 
     // Send three more clock pulses to select 40hz mode again.
     for (uint8_t i = 0; i < 3; i++) {
         gpio_put(device->scl_pin, true);
-        hx710c_delay_300ns();  // T3
+        timing_delay_cycles(hx710c_delay_cycles.t3);  // T3
         gpio_put(device->scl_pin, false);
-        hx710c_delay_300ns();  // T4
+        timing_delay_cycles(hx710c_delay_cycles.t4);  // T4
+    }
+
+    // Re-enabling discards the edges seen while shifting
+    if (drdy_irq_enabled) {
+        gpio_set_irq_enabled(device->sda_pins[0], GPIO_IRQ_EDGE_FALL, true);
+    }
+
+    // Now the bus is idle, turn the bit planes into one word per pin
+    bit_transpose_32x32(bit_planes);
+    for (uint8_t i = 0; i < device->n_sda_pins; i++) {
+        conversions_u32[i] = bit_planes[device->sda_pins[i]];
+    }
+}
+
+bool hx710c_read(hx710c_t* device, int32_t* conversions) {
+    uint32_t* conversions_u32 = (uint32_t*)conversions;
+    if (NULL != device->pio_engine) {
+        // Collect the conversion the state machine already clocked out
+        if (!hx710c_pio_read(device->pio_engine, device->n_sda_pins, conversions_u32, &device->missed_conversions)) {
+            return false;
+        }
+    } else {
+        // Check ready
+        if (!hx710c_is_ready(device)) {
+            return false;
+        }
+        hx710c_read_gpio(device, conversions_u32);
+
+        // Count conversions the DRDY interrupt saw that were never read
+        const uint32_t n_ready = device->n_ready;
+        if (n_ready - device->n_ready_read > 1) {
+            device->missed_conversions += n_ready - device->n_ready_read - 1;
+        }
+        device->n_ready_read = n_ready;
     }
 
     // Convert conversions from 24bit twos complement to int32_t
@@ -112,11 +177,51 @@ bool hx710c_read(hx710c_t* device, int32_t* conversions) {
 }
 
 bool hx710c_is_ready(hx710c_t* device) {
-    // A conversion is ready if the SDA line is low
-    for (uint i = 0; i < device->n_sda_pins; i++) {
-        if (gpio_get(device->sda_pins[i])) {
-            return false;
+    if (NULL != device->pio_engine) {
+        return hx710c_pio_is_ready(device->pio_engine);
+    }
+
+    // A conversion is ready if every SDA line is low
+    return 0 == (gpio_get_all() & device->sda_mask);
+}
+
+static void hx710c_drdy_irq_handler(void) {
+    hx710c_t* const device = hx710c_irq_device;
+    const uint8_t drdy_pin = device->sda_pins[0];
+    if (!(gpio_get_irq_event_mask(drdy_pin) & GPIO_IRQ_EDGE_FALL)) {
+        return;
+    }
+    gpio_acknowledge_irq(drdy_pin, GPIO_IRQ_EDGE_FALL);
+
+    device->n_ready++;
+    device->ready_callback(device->ready_callback_context);
+}
+
+void hx710c_set_ready_callback(hx710c_t* device, hx710c_ready_callback_t callback, void* context) {
+    TANK_ASSERT_M(NULL == hx710c_irq_device || device == hx710c_irq_device,
+                  "Only one HX710C device may have a ready callback");
+    hx710c_irq_device = device;
+
+    if (NULL != device->pio_engine) {
+        device->ready_callback = callback;
+        device->ready_callback_context = context;
+        hx710c_pio_set_ready_callback(device->pio_engine, callback, context);
+        return;
+    }
+
+    // DOUT of the first device falling signals that a conversion is ready
+    const uint8_t drdy_pin = device->sda_pins[0];
+    gpio_set_irq_enabled(drdy_pin, GPIO_IRQ_EDGE_FALL, false);
+    device->ready_callback = callback;
+    device->ready_callback_context = context;
+    device->n_ready_read = device->n_ready;
+    if (NULL != callback) {
+        static bool handler_added = false;
+        if (!handler_added) {
+            gpio_add_raw_irq_handler(drdy_pin, hx710c_drdy_irq_handler);
+            handler_added = true;
         }
+        gpio_set_irq_enabled(drdy_pin, GPIO_IRQ_EDGE_FALL, true);
+        irq_set_enabled(IO_IRQ_BANK0, true);
     }
-    return true;
 }
@@ -1,21 +1,53 @@
-#pragma ONCE
+#pragma once
 
+#include <hardware/pio.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+typedef struct hx710c_pio_engine hx710c_pio_engine_t;
+
+// Called from interrupt context when a conversion is ready to be read.
+typedef void (*hx710c_ready_callback_t)(void* context);
+
 typedef struct hx710c {
     uint8_t scl_pin;
     const uint8_t* sda_pins;
     uint8_t n_sda_pins;
+    uint32_t sda_mask;  // Every SDA pin, as used with gpio_get_all()
+
+    // Set if conversions are clocked out by PIO rather than bit-banged.
+    hx710c_pio_engine_t* pio_engine;
+
+    // Data ready notification
+    hx710c_ready_callback_t ready_callback;
+    void* ready_callback_context;
+    volatile uint32_t n_ready;  // Counted by the DRDY interrupt when bit-banging
+    uint32_t n_ready_read;
+
+    // Number of conversions that were superseded before they were read.
+    uint32_t missed_conversions;
 } hx710c_t;
 
 // Initializes the HX710C devices on the specified pins, filling `device` and 
 // perfroming hardware initialisation.
 // The SDA pins buffer must have the same life time as the hx710 device
 //
+// Bus timing is derived from clk_sys, see util/timing.h. Reinitialise the
+// device if clk_sys changes.
+//
 // Not RTOS aware, the caller must ensure this function is not prememted.
 void hx710c_init(hx710c_t* device, uint8_t scl_pin, const uint8_t* sda_pins, uint8_t n_sda_pins);
 
+// Initializes the HX710C devices on the specified pins like `hx710c_init()`,
+// but hands the pins to a PIO state machine which clocks out every conversion
+// as soon as it is ready. DMA moves finished conversions into RAM, so
+// `hx710c_read()` never touches the bus and may be preempted.
+//
+// The SDA pins must be consecutive and in ascending order, and there may be at
+// most four of them. A conversion is only clocked out once every device has
+// one ready. Only one device may use PIO.
+void hx710c_init_pio(hx710c_t* device, PIO pio, uint8_t scl_pin, const uint8_t* sda_pins, uint8_t n_sda_pins);
+
 // Performs an ADC conversion.
 // `conversions` is a buffer that can hold at least `n_sda_pins` results.
 //
@@ -27,6 +59,9 @@ void hx710c_init(hx710c_t* device, uint8_t scl_pin, const uint8_t* sda_pins, uin
 // the function will return false.
 //
 // Not RTOS aware, the caller must ensure this function is not prememted.
+// Devices initialised with `hx710c_init_pio()` are exempt from both of the
+// above, this only collects the latest conversion and returns false if it has
+// already been read.
 //
 // Returns true on success or false if no data was available.
 bool hx710c_read(hx710c_t *device, int32_t *conversions);
@@ -34,4 +69,12 @@ bool hx710c_read(hx710c_t *device, int32_t *conversions);
 // Returns true if devices are ready to be read.
 bool hx710c_is_ready(hx710c_t *device);
 
+// Calls `callback` from interrupt context every time a conversion becomes ready.
+// For bit-banged devices this is the falling edge of DOUT (DRDY) on the first
+// SDA pin, for PIO devices it is the conversion landing in RAM. Once set,
+// conversions that are not read before the next one is ready are counted in
+// `missed_conversions`.
+//
+// Only one device may register a callback.
+void hx710c_set_ready_callback(hx710c_t* device, hx710c_ready_callback_t callback, void* context);
 
@@ -0,0 +1,143 @@
+#include "hx710c_pio.h"
+
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/pio.h>
+#include <pico/platform.h>
+#include <string.h>
+
+#include "hx710c.pio.h"
+#include "util/bit_transpose.h"
+#include "util/tank_assert.h"
+
+// One word is pushed per SCL pulse while the conversion is shifted out
+#define HX710C_PIO_WORDS_PER_CONVERSION 24
+#define HX710C_PIO_N_BUFFERS 2
+
+struct hx710c_pio_engine {
+    PIO pio;
+    uint sm;
+    uint dma_channels[HX710C_PIO_N_BUFFERS];
+    uint32_t buffers[HX710C_PIO_N_BUFFERS][HX710C_PIO_WORDS_PER_CONVERSION];
+
+    // Written by the DMA IRQ handler
+    volatile uint8_t latest_buffer;
+    volatile uint32_t sequence;
+
+    // Called by the DMA IRQ handler
+    void (*volatile ready_callback)(void*);
+    void* ready_callback_context;
+
+    // Sequence number of the last conversion handed out by hx710c_pio_read()
+    uint32_t read_sequence;
+};
+
+static hx710c_pio_engine_t hx710c_pio_engine;
+static bool hx710c_pio_engine_running = false;
+
+static void hx710c_pio_dma_irq_handler(void) {
+    hx710c_pio_engine_t* const engine = &hx710c_pio_engine;
+    for (uint8_t i = 0; i < HX710C_PIO_N_BUFFERS; i++) {
+        const uint channel = engine->dma_channels[i];
+        if (!dma_channel_get_irq0_status(channel)) {
+            continue;
+        }
+        dma_channel_acknowledge_irq0(channel);
+
+        // Rewind, without triggering, so the next time this channel is chained
+        // to it fills the same buffer again. The transfer count reloads itself.
+        dma_channel_set_write_addr(channel, engine->buffers[i], false);
+
+        engine->latest_buffer = i;
+        engine->sequence++;
+
+        if (NULL != engine->ready_callback) {
+            engine->ready_callback(engine->ready_callback_context);
+        }
+    }
+}
+
+hx710c_pio_engine_t* hx710c_pio_start(PIO pio, uint8_t scl_pin, uint8_t sda_base_pin, uint8_t n_devices) {
+    TANK_ASSERT_M(!hx710c_pio_engine_running, "Only one HX710C PIO engine is supported");
+    TANK_ASSERT_M(n_devices >= 1 && n_devices <= hx710c_MAX_DEVICES,
+                  "The HX710C PIO program waits for at most %u devices", hx710c_MAX_DEVICES);
+    hx710c_pio_engine_t* const engine = &hx710c_pio_engine;
+    memset(engine, 0, sizeof(hx710c_pio_engine_t));
+
+    // State machine
+    engine->pio = pio;
+    engine->sm = pio_claim_unused_sm(pio, true);
+    const uint offset = pio_add_program(pio, &hx710c_program);
+    hx710c_program_init(pio, engine->sm, offset, scl_pin, sda_base_pin, n_devices);
+
+    // DMA, each channel fills its own buffer then hands over to the other
+    for (uint8_t i = 0; i < HX710C_PIO_N_BUFFERS; i++) {
+        engine->dma_channels[i] = dma_claim_unused_channel(true);
+    }
+    for (uint8_t i = 0; i < HX710C_PIO_N_BUFFERS; i++) {
+        const uint channel = engine->dma_channels[i];
+        dma_channel_config config = dma_channel_get_default_config(channel);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+        channel_config_set_read_increment(&config, false);
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_dreq(&config, pio_get_dreq(pio, engine->sm, false));
+        channel_config_set_chain_to(&config, engine->dma_channels[(i + 1) % HX710C_PIO_N_BUFFERS]);
+        dma_channel_configure(channel, &config, engine->buffers[i], &pio->rxf[engine->sm],
+                              HX710C_PIO_WORDS_PER_CONVERSION, false);
+        dma_channel_set_irq0_enabled(channel, true);
+    }
+    irq_add_shared_handler(DMA_IRQ_0, hx710c_pio_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    // Go
+    dma_channel_start(engine->dma_channels[0]);
+    pio_sm_set_enabled(pio, engine->sm, true);
+    hx710c_pio_engine_running = true;
+
+    return engine;
+}
+
+bool hx710c_pio_read(hx710c_pio_engine_t* engine, uint8_t n_devices, uint32_t* raw_conversions,
+                     uint32_t* missed_conversions) {
+    uint32_t words[HX710C_PIO_WORDS_PER_CONVERSION];
+    uint32_t sequence;
+
+    // The buffer being copied is not written to again until a whole conversion
+    // later, but retry if a conversion completes mid copy so the copy is
+    // always of the latest buffer.
+    do {
+        sequence = engine->sequence;
+        if (sequence == engine->read_sequence) {
+            return false;
+        }
+        __compiler_memory_barrier();
+        memcpy(words, engine->buffers[engine->latest_buffer], sizeof(words));
+        __compiler_memory_barrier();
+    } while (sequence != engine->sequence);
+    *missed_conversions += sequence - engine->read_sequence - 1;
+    engine->read_sequence = sequence;
+
+    // Words arrive MSB first and bit n of each word belongs to the nth device.
+    // Reorder them into bit planes, LSB first, and transpose to one word per device.
+    const uint32_t device_mask = n_devices < 32 ? (1u << n_devices) - 1 : 0xFFFFFFFF;
+    uint32_t bit_planes[32] = {0};
+    for (uint8_t i = 0; i < HX710C_PIO_WORDS_PER_CONVERSION; i++) {
+        bit_planes[HX710C_PIO_WORDS_PER_CONVERSION - 1 - i] = words[i] & device_mask;
+    }
+    bit_transpose_32x32(bit_planes);
+    memcpy(raw_conversions, bit_planes, n_devices * sizeof(uint32_t));
+
+    return true;
+}
+
+bool hx710c_pio_is_ready(const hx710c_pio_engine_t* engine) {
+    return engine->sequence != engine->read_sequence;
+}
+
+void hx710c_pio_set_ready_callback(hx710c_pio_engine_t* engine, void (*callback)(void*), void* context) {
+    engine->ready_callback = NULL;
+    __compiler_memory_barrier();
+    engine->ready_callback_context = context;
+    __compiler_memory_barrier();
+    engine->ready_callback = callback;
+}
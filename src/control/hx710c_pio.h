@@ -0,0 +1,32 @@
+#pragma once
+
+#include <hardware/pio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Internal to the HX710C driver, use the API in hx710c.h instead.
+//
+// The PIO engine clocks every conversion out of the HX710C devices as soon as
+// it is ready. Two DMA channels, chained to each other, take turns moving the
+// words pushed by the state machine into a pair of conversion buffers, so the
+// CPU only ever touches finished conversions.
+
+typedef struct hx710c_pio_engine hx710c_pio_engine_t;
+
+// Claims a state machine and two DMA channels and starts acquisition of
+// `n_devices` devices, at most hx710c_MAX_DEVICES, on consecutive SDA pins.
+// Only one engine may be running at a time.
+hx710c_pio_engine_t* hx710c_pio_start(PIO pio, uint8_t scl_pin, uint8_t sda_base_pin, uint8_t n_devices);
+
+// Copies the raw 24 bit conversions of the `n_devices` devices out of the most
+// recently completed buffer. Returns false if there is no conversion that has
+// not already been read. Conversions that were superseded before being read
+// are added to `missed_conversions`.
+bool hx710c_pio_read(hx710c_pio_engine_t* engine, uint8_t n_devices, uint32_t* raw_conversions,
+                     uint32_t* missed_conversions);
+
+// Calls `callback` from the DMA IRQ every time a conversion lands in RAM.
+void hx710c_pio_set_ready_callback(hx710c_pio_engine_t* engine, void (*callback)(void*), void* context);
+
+// Returns true if a conversion has completed that has not already been read.
+bool hx710c_pio_is_ready(const hx710c_pio_engine_t* engine);
@@ -9,15 +9,18 @@
 #include "config/config.h"
 #include "control/types.h"
 #include "control_map.h"
-#include "hardware/adc.h"
-#include "hx710c.h"
+#include "control_pipeline.h"
+#include "pedal_adc.h"
 #include "pins.h"
 #include "projdefs.h"
 #include "task.h"
 #include "terminal/terminal.h"
+#include "tiller_predictor.h"
+#include "tiller_task.h"
+#include "usb_keyboard/gamepad.h"
 #include "usb_keyboard/keyboard_task.h"
 #include "usb_keyboard/types.h"
-#include "util/helpers.h"
+#include "util/quantile.h"
 #include "util/tank_assert.h"
 
 // Logging
@@ -30,7 +33,21 @@ static StaticTask_t input_task_control_block;
 
 // Globals
 static TickType_t input_interval = 0;
-static hx710c_t input_force_sensors;
+
+// Tiller prediction between force sensor conversions
+static tiller_predictor_t input_left_tiller_predictor;
+static tiller_predictor_t input_right_tiller_predictor;
+static bool input_tiller_predictors_initialised = false;
+
+// Per channel filters, set up from the control settings
+static const filter_config_t input_default_pedal_filter = {.type = FILTER_EMA, .ema_alpha_q16 = 16384};
+static const filter_config_t input_default_tiller_filter = {
+    .type = FILTER_BIQUAD_LOW_PASS, .biquad_cutoff_mhz = 8000, .biquad_sample_rate_hz = 40};
+static filter_t input_accelerator_filter;
+static filter_t input_brake_filter;
+static filter_t input_clutch_filter;
+static filter_t input_left_tiller_filter;
+static filter_t input_right_tiller_filter;
 
 // Calibration
 const control_raw_report_t control_default_calibration_min = {
@@ -51,34 +68,125 @@ const control_raw_report_t control_default_calibration_max = {
     .right_tiller = INPUT_RAW_TILLER_ABSOLUTE_MIN  //
 };
 
+// Calibration ranges are robust percentiles, so a knock on a sensor during
+// calibration does not skew them
+#define INPUT_CALIBRATION_LOW_QUANTILE_Q16 655     // 1st percentile
+#define INPUT_CALIBRATION_HIGH_QUANTILE_Q16 64881  // 99th percentile
+
+typedef struct input_calibration_range {
+    quantile_t low;
+    quantile_t high;
+} input_calibration_range_t;
+
+static input_calibration_range_t input_accelerator_range;
+static input_calibration_range_t input_brake_range;
+static input_calibration_range_t input_clutch_range;
+static input_calibration_range_t input_left_tiller_range;
+static input_calibration_range_t input_right_tiller_range;
+static uint32_t input_calibration_tillers_us = 0;  // Timestamp of the last tiller sample calibrated against
+
+// Auto-tare
+static auto_tare_t input_left_tiller_tare;
+static auto_tare_t input_right_tiller_tare;
+static uint32_t input_auto_tare_tillers_us = 0;  // Timestamp of the last tiller sample tared against
+
+// Channels no mapping consumes are still read every INPUT_HOUSEKEEPING_CYCLES
+// cycles, so their values stay usable for logging
+#define INPUT_HOUSEKEEPING_CYCLES 100
+
+// Reads the channels in `channels`, leaving the others as they were.
 // Returns true if all sensors have bene successfully read
-static bool input_task_update_sensor_values(control_raw_report_t* sensor_values) {
+static bool input_task_update_sensor_values(control_raw_report_t* sensor_values,
+                                            control_raw_timestamps_t* timestamps,
+                                            control_raw_channel_mask_t channels) {
     bool result = true;
 
-    // Read force sensors
-    int32_t conversions[2] = {0};
-    vTaskSuspendAll();
-    bool conversion_ready = hx710c_read(&input_force_sensors, conversions);
-    xTaskResumeAll();
-    if (!conversion_ready) {
-        LOG_W(input_log_tag, "Force sensor conversion was not ready.");
+    // Take the latest tiller sample, the tiller task acquires these at their own rate
+    tiller_sample_t tillers;
+    if (!tiller_task_get_latest(&tillers)) {
         result = false;
-    } else {
-        sensor_values->left_tiller = conversions[0];
-        sensor_values->right_tiller = conversions[1];
+    } else if (!input_tiller_predictors_initialised || tillers.timestamp_us != timestamps->tillers_us) {
+        if (channels & CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_LEFT_TILLER)) {
+            sensor_values->left_tiller = filter_apply(&input_left_tiller_filter, tillers.left_tiller);
+            tiller_predictor_update(&input_left_tiller_predictor, sensor_values->left_tiller, tillers.timestamp_us);
+        }
+        if (channels & CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_RIGHT_TILLER)) {
+            sensor_values->right_tiller = filter_apply(&input_right_tiller_filter, tillers.right_tiller);
+            tiller_predictor_update(&input_right_tiller_predictor, sensor_values->right_tiller, tillers.timestamp_us);
+        }
+        timestamps->tillers_us = tillers.timestamp_us;
+        input_tiller_predictors_initialised = true;
     }
 
-    // Read pedals
-    adc_select_input(PIN_TO_ADC(ACCELERATOR_PEDAL_PIN));
-    sensor_values->accelerator = adc_read();
-    adc_select_input(PIN_TO_ADC(BRAKE_PEDAL_PIN));
-    sensor_values->brake = adc_read();
-    adc_select_input(PIN_TO_ADC(CLUTCH_PEDAL_PIN));
-    sensor_values->clutch = adc_read();
+    // Read pedals, these are always fresh
+    if (channels & CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_ACCELERATOR)) {
+        sensor_values->accelerator =
+            (int16_t)filter_apply(&input_accelerator_filter, pedal_adc_read(ACCELERATOR_PEDAL_PIN));
+    }
+    if (channels & CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_BRAKE)) {
+        sensor_values->brake = (int16_t)filter_apply(&input_brake_filter, pedal_adc_read(BRAKE_PEDAL_PIN));
+    }
+    if (channels & CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_CLUTCH)) {
+        sensor_values->clutch = (int16_t)filter_apply(&input_clutch_filter, pedal_adc_read(CLUTCH_PEDAL_PIN));
+    }
+    timestamps->pedals_us = time_us_32();
 
     return result;
 }
 
+// Returns a copy of `current` with the tillers estimated at the time the pedals
+// were read, plus `horizon_us`
+static control_raw_report_t input_predict_tillers(const control_raw_report_t* current,
+                                                  const control_raw_timestamps_t* timestamps,
+                                                  uint32_t horizon_us) {
+    control_raw_report_t predicted = *current;
+    predicted.left_tiller = tiller_predictor_estimate(&input_left_tiller_predictor, timestamps->pedals_us, horizon_us);
+    predicted.right_tiller =
+        tiller_predictor_estimate(&input_right_tiller_predictor, timestamps->pedals_us, horizon_us);
+    return predicted;
+}
+
+// Moves a tiller's calibrated range by the auto-tare correction, if there is one
+static bool input_auto_tare_tiller(auto_tare_t* tare,
+                                   const auto_tare_settings_t* settings,
+                                   const control_ramp_t* ramp,
+                                   q16_t deadzone,
+                                   int32_t current,
+                                   uint32_t timestamp_us,
+                                   int32_t* min,
+                                   int32_t* max) {
+    const bool at_rest = control_ramp_apply(ramp, current) < deadzone;
+    int32_t correction = 0;
+    if (!auto_tare_add(tare, settings, current, at_rest, *min, timestamp_us, &correction)) {
+        return false;
+    }
+    *min += correction;
+    *max += correction;
+    return true;
+}
+
+// Lets the tiller zeros follow drift, returns true if the calibration changed
+static bool input_auto_tare(const control_raw_report_t* current,
+                            const control_raw_timestamps_t* timestamps,
+                            const control_settings_t* settings,
+                            control_raw_report_t* min,
+                            control_raw_report_t* max) {
+    // Once per tiller conversion
+    if (timestamps->tillers_us == input_auto_tare_tillers_us) {
+        return false;
+    }
+    input_auto_tare_tillers_us = timestamps->tillers_us;
+
+    const control_transform_t* transform = control_transform_get();
+    bool changed = input_auto_tare_tiller(&input_left_tiller_tare, &settings->tiller_auto_tare,
+                                          &transform->left_tiller, transform->tiller_deadzone, current->left_tiller,
+                                          timestamps->tillers_us, &min->left_tiller, &max->left_tiller);
+    changed |= input_auto_tare_tiller(&input_right_tiller_tare, &settings->tiller_auto_tare,
+                                      &transform->right_tiller, transform->tiller_deadzone, current->right_tiller,
+                                      timestamps->tillers_us, &min->right_tiller, &max->right_tiller);
+    return changed;
+}
+
 static bool input_calibration_mode_enabled(bool* out_exited_calibration_mode, bool* out_entered_calibration_mode) {
     static bool enabled = false;
     static bool enabled_last_call = false;
@@ -118,66 +226,144 @@ static bool input_calibration_mode_enabled(bool* out_exited_calibration_mode, bo
     return enabled;
 }
 
+static void input_calibration_range_reset(input_calibration_range_t* range) {
+    quantile_init(&range->low, INPUT_CALIBRATION_LOW_QUANTILE_Q16);
+    quantile_init(&range->high, INPUT_CALIBRATION_HIGH_QUANTILE_Q16);
+}
+
+static void input_calibration_range_add(input_calibration_range_t* range, int32_t sample) {
+    quantile_add(&range->low, sample);
+    quantile_add(&range->high, sample);
+}
+
+// Starts a new calibration
+static void input_calibration_reset(void) {
+    input_calibration_range_reset(&input_accelerator_range);
+    input_calibration_range_reset(&input_brake_range);
+    input_calibration_range_reset(&input_clutch_range);
+    input_calibration_range_reset(&input_left_tiller_range);
+    input_calibration_range_reset(&input_right_tiller_range);
+    input_calibration_tillers_us = 0;
+    auto_tare_init(&input_left_tiller_tare);
+    auto_tare_init(&input_right_tiller_tare);
+}
+
 // Updates max and min based off the current sensor reading
-static void input_calibrate(const control_raw_report_t* current, control_raw_report_t* min, control_raw_report_t* max) {
+static void input_calibrate(const control_raw_report_t* current,
+                            const control_raw_timestamps_t* timestamps,
+                            control_raw_report_t* min,
+                            control_raw_report_t* max) {
+    // Pedals are fresh every call
+    input_calibration_range_add(&input_accelerator_range, current->accelerator);
+    input_calibration_range_add(&input_brake_range, current->brake);
+    input_calibration_range_add(&input_clutch_range, current->clutch);
+
+    // Tillers only count once per conversion, so they are not weighted by how long a value was held
+    if (0 == input_calibration_tillers_us || timestamps->tillers_us != input_calibration_tillers_us) {
+        input_calibration_range_add(&input_left_tiller_range, current->left_tiller);
+        input_calibration_range_add(&input_right_tiller_range, current->right_tiller);
+        input_calibration_tillers_us = timestamps->tillers_us;
+    }
+
     // Update min
-    min->accelerator = MIN_OF(min->accelerator, current->accelerator);
-    min->brake = MIN_OF(min->brake, current->brake);
-    min->clutch = MIN_OF(min->clutch, current->clutch);
-    min->left_tiller = MIN_OF(min->left_tiller, current->left_tiller);
-    min->right_tiller = MIN_OF(min->right_tiller, current->right_tiller);
+    min->accelerator = (int16_t)quantile_get(&input_accelerator_range.low);
+    min->brake = (int16_t)quantile_get(&input_brake_range.low);
+    min->clutch = (int16_t)quantile_get(&input_clutch_range.low);
+    min->left_tiller = quantile_get(&input_left_tiller_range.low);
+    min->right_tiller = quantile_get(&input_right_tiller_range.low);
 
     // Update max
-    max->accelerator = MAX_OF(max->accelerator, current->accelerator);
-    max->brake = MAX_OF(max->brake, current->brake);
-    max->clutch = MAX_OF(max->clutch, current->clutch);
-    max->left_tiller = MAX_OF(max->left_tiller, current->left_tiller);
-    max->right_tiller = MAX_OF(max->right_tiller, current->right_tiller);
+    max->accelerator = (int16_t)quantile_get(&input_accelerator_range.high);
+    max->brake = (int16_t)quantile_get(&input_brake_range.high);
+    max->clutch = (int16_t)quantile_get(&input_clutch_range.high);
+    max->left_tiller = quantile_get(&input_left_tiller_range.high);
+    max->right_tiller = quantile_get(&input_right_tiller_range.high);
+}
+
+static bool input_filter_config_equal(const filter_config_t* a, const filter_config_t* b) {
+    return a->type == b->type && a->ema_alpha_q16 == b->ema_alpha_q16 &&
+           a->biquad_cutoff_mhz == b->biquad_cutoff_mhz && a->biquad_sample_rate_hz == b->biquad_sample_rate_hz;
 }
 
-// Scales raw values to between 0.0 and 1.0
-static float input_scale_to_0_1(float current_raw, float min_raw, float max_raw) {
-    // Do not divide by zero
-    if (max_raw == min_raw) {
-        return 0;
+// Sets up a channel filter, keeping its state if its config is unchanged from `previous`
+static void input_filter_configure(filter_t* filter, const filter_config_t* config, const filter_config_t* previous) {
+    if (NULL == previous || !input_filter_config_equal(config, previous)) {
+        filter_init(filter, config);
     }
+}
 
-    float value = (current_raw - min_raw) / (max_raw - min_raw);
-    value = MAX_OF(value, 0.0);
-    value = MIN_OF(value, 1.0);
-    return value;
+static void input_filters_configure(const control_settings_t* settings, const control_settings_t* previous) {
+    input_filter_configure(&input_accelerator_filter, &settings->accelerator_filter,
+                           NULL == previous ? NULL : &previous->accelerator_filter);
+    input_filter_configure(&input_brake_filter, &settings->brake_filter,
+                           NULL == previous ? NULL : &previous->brake_filter);
+    input_filter_configure(&input_clutch_filter, &settings->clutch_filter,
+                           NULL == previous ? NULL : &previous->clutch_filter);
+    input_filter_configure(&input_left_tiller_filter, &settings->left_tiller_filter,
+                           NULL == previous ? NULL : &previous->left_tiller_filter);
+    input_filter_configure(&input_right_tiller_filter, &settings->right_tiller_filter,
+                           NULL == previous ? NULL : &previous->right_tiller_filter);
 }
 
-static input_report_t input_make_report(const control_raw_report_t* current,
-                                        const control_raw_report_t* calibration_min,
-                                        const control_raw_report_t* calibration_max) {
-    input_report_t report = {
-        // High raw accelerator values indicate that the accelerator is not depressed
-        .accelerator =
-            1.0 - input_scale_to_0_1(current->accelerator, calibration_min->accelerator, calibration_max->accelerator),
-        .left_tiller =
-            input_scale_to_0_1(current->left_tiller, calibration_min->left_tiller, calibration_max->left_tiller),
-        .right_tiller =
-            input_scale_to_0_1(current->right_tiller, calibration_min->right_tiller, calibration_max->right_tiller),
-        // TODO gear selection
-        .gear = INPUT_FORWARDS};
-
-    return report;
+static bool input_raw_report_equal(const control_raw_report_t* a, const control_raw_report_t* b) {
+    return a->accelerator == b->accelerator && a->brake == b->brake && a->clutch == b->clutch &&
+           a->left_tiller == b->left_tiller && a->right_tiller == b->right_tiller;
 }
 
-static void input_task(void* unused) {
-    TickType_t wake_time = xTaskGetTickCount();
+// Generations of the config last loaded by the input task
+typedef struct input_config_generation {
+    uint32_t calibration;
+    uint32_t control_settings;
+} input_config_generation_t;
+
+// Sends the output to the backend the settings select and holds the other
+// released. Both only pass on changes, so this is cheap every cycle. Only the
+// gamepad reports the brake.
+static void input_set_output(const control_settings_t* settings, const keyboard_output_t* output, q16_t brake) {
+    static const keyboard_output_t nil_output = {0};
+    const bool gamepad = CONTROL_OUTPUT_GAMEPAD == settings->output_backend;
+    keyboard_task_set_output(gamepad ? &nil_output : output);
+    gamepad_set_output(gamepad ? output : &nil_output, gamepad ? brake : Q16_ZERO);
+}
 
-    // Set up force sensors
-    // Setup force sensors
-    const uint8_t force_sensor_sda_pins[] = {
-        LEFT_TILLER_SDA_PIN,
-        RIGHT_TILLER_SDA_PIN,
-    };
-    vTaskSuspendAll();
-    hx710c_init(&input_force_sensors, TILLER_SCL_PIN, force_sensor_sda_pins, 2);
-    xTaskResumeAll();
+// Picks up calibration and control settings set since `generation`, then
+// rebuilds what is derived from them. Costs two atomic loads when nothing changed.
+static void input_config_reload(input_config_generation_t* generation,
+                                control_settings_t* settings,
+                                control_raw_report_t* calibration_min,
+                                control_raw_report_t* calibration_max) {
+    const input_config_generation_t latest = {.calibration = config_get_calibration_generation(),
+                                              .control_settings = config_get_control_settings_generation()};
+    const bool calibration_changed = latest.calibration != generation->calibration;
+    const bool settings_changed = latest.control_settings != generation->control_settings;
+    if (!calibration_changed && !settings_changed) {
+        return;
+    }
+    *generation = latest;
+
+    // A new zero invalidates the auto-tare windows in progress
+    if (calibration_changed) {
+        const control_raw_report_t previous_min = *calibration_min;
+        const control_raw_report_t previous_max = *calibration_max;
+        config_get_calibration(calibration_min, calibration_max);
+        if (!input_raw_report_equal(calibration_min, &previous_min) ||
+            !input_raw_report_equal(calibration_max, &previous_max)) {
+            auto_tare_init(&input_left_tiller_tare);
+            auto_tare_init(&input_right_tiller_tare);
+        }
+    }
+    if (settings_changed) {
+        const control_settings_t previous = *settings;
+        config_get_control_settings(settings);
+        input_filters_configure(settings, &previous);
+        keyboard_task_set_consumer_tick(settings->consumer_tick_us);
+    }
+    control_transform_update(settings, calibration_min, calibration_max);
+    LOG_D(input_log_tag, "Reloaded config, calibration: %u, control settings: %u", latest.calibration,
+          latest.control_settings);
+}
 
+static void input_task(void* unused) {
     // Calibration
     control_raw_report_t calibration_min = control_default_calibration_min;
     control_raw_report_t calibration_max = control_default_calibration_max;
@@ -187,11 +373,33 @@ static void input_task(void* unused) {
                                            .tiller_deadzone = 0.07,
                                            .tiller_handbrake_threshold_begin = 0.8,
                                            .tiller_handbrake_threshold_end = 0.9,
-                                           .tiller_max_turn_threshold = 0.65};
-
-    // Read from config
-    // config_get_calibration(&calibration_min, &calibration_max);
+                                           .tiller_max_turn_threshold = 0.65,
+                                           .tiller_prediction_horizon_us = 10000,
+                                           .accelerator_filter = input_default_pedal_filter,
+                                           .brake_filter = input_default_pedal_filter,
+                                           .clutch_filter = input_default_pedal_filter,
+                                           .left_tiller_filter = input_default_tiller_filter,
+                                           .right_tiller_filter = input_default_tiller_filter,
+                                           .pedal_response_curve = {.type = RESPONSE_CURVE_LINEAR},
+                                           .tiller_response_curve = {.type = RESPONSE_CURVE_LINEAR},
+                                           .tiller_auto_tare = {.window_us = 2000000,
+                                                                .max_deviation = 2000,
+                                                                .correction_q16 = 6554},  // 10% per window
+                                           .auto_tare_save_interval_ms = 10 * 60 * 1000,
+                                           .output_backend = CONTROL_OUTPUT_KEYBOARD,
+                                           .consumer_tick_us = 0};
+
+    // Read from config, the generations are taken first so a change made while
+    // reading is picked up on the first cycle
+    input_config_generation_t config_generation = {.calibration = config_get_calibration_generation(),
+                                                   .control_settings = config_get_control_settings_generation()};
+    config_get_calibration(&calibration_min, &calibration_max);
     config_get_control_settings(&control_settings);
+    control_transform_update(&control_settings, &calibration_min, &calibration_max);
+    keyboard_task_set_consumer_tick(control_settings.consumer_tick_us);
+
+    // Filters
+    input_filters_configure(&control_settings, NULL);
 
     // Init current report
     control_raw_report_t current_report = {
@@ -201,35 +409,79 @@ static void input_task(void* unused) {
         .left_tiller = 0,                             //
         .right_tiller = 0                             //
     };
-    while (!input_task_update_sensor_values(&current_report)) {
-        // NOP
+    control_raw_timestamps_t current_timestamps = {0};
+    while (!input_task_update_sensor_values(&current_report, &current_timestamps, CONTROL_RAW_ALL_CHANNELS)) {
+        vTaskDelay(input_interval);
     }
 
+    // Auto-tare corrections are saved at a bounded rate to spare the flash
+    bool auto_tare_unsaved = false;
+    TickType_t auto_tare_last_save = xTaskGetTickCount();
+
+    // Only the channels the mapping consumes are read every cycle, and the brake
+    // for the gamepad. Calibration needs them all.
+    const control_raw_channel_mask_t mapped_channels = control_pipeline_channels();
+    uint32_t housekeeping_countdown = 0;
+    bool calibrating = false;
+
+    TickType_t wake_time = xTaskGetTickCount();
     while (1) {
         // Read sensors
-        input_task_update_sensor_values(&current_report);
+        control_raw_channel_mask_t channels = mapped_channels;
+        if (CONTROL_OUTPUT_GAMEPAD == control_settings.output_backend) {
+            channels |= CONTROL_MAP_BRAKE_CHANNELS;
+        }
+        if (calibrating || 0 == housekeeping_countdown) {
+            channels = CONTROL_RAW_ALL_CHANNELS;
+            housekeeping_countdown = INPUT_HOUSEKEEPING_CYCLES;
+        }
+        housekeeping_countdown--;
+        input_task_update_sensor_values(&current_report, &current_timestamps, channels);
 
         // Process sensor data
         bool save_calibration_data = false;
         bool reset_calibration_data = false;
-        if (input_calibration_mode_enabled(&save_calibration_data, &reset_calibration_data)) {
+        calibrating = input_calibration_mode_enabled(&save_calibration_data, &reset_calibration_data);
+        if (calibrating) {
             if (reset_calibration_data) {
                 LOG_D(input_log_tag, "Reset calibration data.");
-                control_raw_report_t calibration_min = control_default_calibration_min;
-                control_raw_report_t calibration_max = control_default_calibration_max;
+                calibration_min = control_default_calibration_min;
+                calibration_max = control_default_calibration_max;
+                input_calibration_reset();
             }
             keyboard_output_t nil_output = {0};
-            keyboard_task_set_output(&nil_output);
-            input_calibrate(&current_report, &calibration_min, &calibration_max);
+            input_set_output(&control_settings, &nil_output, Q16_ZERO);
+            input_calibrate(&current_report, &current_timestamps, &calibration_min, &calibration_max);
         } else {
-            input_report_t input = input_make_report(&current_report, &calibration_min, &calibration_max);
-            keyboard_output_t output = map_input_to_output(&control_settings, &input);
-            keyboard_task_set_output(&output);
+            // Calibration mode owns the calibration, so changes are only taken outside it
+            input_config_reload(&config_generation, &control_settings, &calibration_min, &calibration_max);
+
+            control_raw_report_t predicted_report = input_predict_tillers(
+                &current_report, &current_timestamps, control_settings.tiller_prediction_horizon_us);
+            const control_transform_t* transform = control_transform_get();
+            keyboard_output_t output = control_pipeline_run(transform, &predicted_report);
+            input_set_output(&control_settings, &output, map_brake(transform, current_report.brake));
+
+            // Track load cell drift
+            if (input_auto_tare(&current_report, &current_timestamps, &control_settings, &calibration_min,
+                                &calibration_max)) {
+                control_transform_update(&control_settings, &calibration_min, &calibration_max);
+                auto_tare_unsaved = true;
+            }
+            if (auto_tare_unsaved && xTaskGetTickCount() - auto_tare_last_save >=
+                                         pdMS_TO_TICKS(control_settings.auto_tare_save_interval_ms)) {
+                config_set_calibration(&calibration_min, &calibration_max);
+                auto_tare_unsaved = false;
+                auto_tare_last_save = xTaskGetTickCount();
+                LOG_D(input_log_tag, "Saved auto-tare, left_tiller: %d, right_tiller: %d", calibration_min.left_tiller,
+                      calibration_min.right_tiller);
+            }
         }
 
         // Save calibration data
         if (save_calibration_data) {
             config_set_calibration(&calibration_min, &calibration_max);
+            control_transform_update(&control_settings, &calibration_min, &calibration_max);
             LOG_D(input_log_tag, "Calibration minimums:");
             LOG_D(input_log_tag, "  accelerator: %d", calibration_min.accelerator);
             LOG_D(input_log_tag, "  left_tiller: %d", calibration_min.left_tiller);
@@ -256,10 +508,14 @@ void input_task_start(UBaseType_t priority, TickType_t interval) {
 
 void input_task_init(void) {
     // Setup pedals
-    adc_init();
-    adc_gpio_init(ACCELERATOR_PEDAL_PIN);
-    adc_gpio_init(BRAKE_PEDAL_PIN);
-    adc_gpio_init(CLUTCH_PEDAL_PIN);
+    pedal_adc_init();
+
+    // Setup calibration
+    input_calibration_reset();
+
+    // Setup tiller prediction
+    tiller_predictor_init(&input_left_tiller_predictor);
+    tiller_predictor_init(&input_right_tiller_predictor);
 
     // Setup calibration switch
     gpio_init(CALIBRATION_SWITCH_PIN);
@@ -5,4 +5,6 @@
 void input_task_init(void);
 
 // This task is responsible for generating the input report.
+// It runs every `interval`, combining freshly read pedals with the latest
+// sample from the tiller task.
 void input_task_start(UBaseType_t priority, TickType_t interval);
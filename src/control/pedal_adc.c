@@ -0,0 +1,82 @@
+#include "pedal_adc.h"
+
+#include <hardware/adc.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <stdint.h>
+
+#include "pins.h"
+#include "util/tank_assert.h"
+
+// Round-robin covers ADC inputs 0-3. Only 0-2 are pedals, but a power of two
+// slots keeps every input at a fixed position in the ring.
+#define PEDAL_ADC_N_SLOTS 4
+#define PEDAL_ADC_ROUND_ROBIN_MASK ((1 << PEDAL_ADC_N_SLOTS) - 1)
+
+// Ring
+#define PEDAL_ADC_RING_SAMPLES (PEDAL_ADC_N_SLOTS * PEDAL_ADC_OVERSAMPLING)
+#define PEDAL_ADC_RING_BYTES (PEDAL_ADC_RING_SAMPLES * sizeof(uint16_t))
+#define PEDAL_ADC_RING_SIZE_BITS 7
+static_assert(PEDAL_ADC_RING_BYTES == (1 << PEDAL_ADC_RING_SIZE_BITS), "DMA rings must be a power of two in size");
+static volatile uint16_t pedal_adc_ring[PEDAL_ADC_RING_SAMPLES] __attribute__((aligned(PEDAL_ADC_RING_BYTES)));
+
+// Sum of PEDAL_ADC_OVERSAMPLING 12 bit samples, down to PEDAL_ADC_RESOLUTION_BITS
+#define PEDAL_ADC_SAMPLE_BITS 12
+#define PEDAL_ADC_DECIMATION_SHIFT (PEDAL_ADC_SAMPLE_BITS + 4 - PEDAL_ADC_RESOLUTION_BITS)
+static_assert(PEDAL_ADC_OVERSAMPLING == 16, "PEDAL_ADC_DECIMATION_SHIFT assumes 16x oversampling");
+
+// The ADC runs from the 48MHz USB PLL, taking 96 cycles per conversion at most
+#define PEDAL_ADC_CLOCK_HZ 48000000
+#define PEDAL_ADC_SAMPLE_RATE_HZ (PEDAL_ADC_WINDOW_HZ * PEDAL_ADC_RING_SAMPLES)
+
+static uint pedal_adc_dma_channel;
+
+static void pedal_adc_dma_irq_handler(void) {
+    if (!dma_channel_get_irq0_status(pedal_adc_dma_channel)) {
+        return;
+    }
+    dma_channel_acknowledge_irq0(pedal_adc_dma_channel);
+
+    // The transfer count has run out, which takes many hours. Keep going.
+    dma_channel_set_trans_count(pedal_adc_dma_channel, UINT32_MAX, true);
+}
+
+void pedal_adc_init(void) {
+    // GPIOs
+    adc_init();
+    adc_gpio_init(ACCELERATOR_PEDAL_PIN);
+    adc_gpio_init(BRAKE_PEDAL_PIN);
+    adc_gpio_init(CLUTCH_PEDAL_PIN);
+
+    // Free running round-robin, starting at input 0 so it lands at the start of the ring
+    adc_select_input(0);
+    adc_set_round_robin(PEDAL_ADC_ROUND_ROBIN_MASK);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv((float)PEDAL_ADC_CLOCK_HZ / PEDAL_ADC_SAMPLE_RATE_HZ - 1);
+
+    // DMA from the ADC FIFO into the ring
+    pedal_adc_dma_channel = dma_claim_unused_channel(true);
+    dma_channel_config config = dma_channel_get_default_config(pedal_adc_dma_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_ring(&config, true, PEDAL_ADC_RING_SIZE_BITS);
+    channel_config_set_dreq(&config, DREQ_ADC);
+    dma_channel_configure(pedal_adc_dma_channel, &config, pedal_adc_ring, &adc_hw->fifo, UINT32_MAX, false);
+    dma_channel_set_irq0_enabled(pedal_adc_dma_channel, true);
+    irq_add_shared_handler(DMA_IRQ_0, pedal_adc_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    // Go
+    dma_channel_start(pedal_adc_dma_channel);
+    adc_run(true);
+}
+
+uint16_t pedal_adc_read(uint8_t pin) {
+    // Every PEDAL_ADC_N_SLOTS sample belongs to the same input
+    uint32_t sum = 0;
+    for (uint32_t i = PIN_TO_ADC(pin); i < PEDAL_ADC_RING_SAMPLES; i += PEDAL_ADC_N_SLOTS) {
+        sum += pedal_adc_ring[i];
+    }
+    return (uint16_t)(sum >> PEDAL_ADC_DECIMATION_SHIFT);
+}
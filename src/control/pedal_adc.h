@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+// Free running pedal acquisition.
+//
+// The ADC converts round-robin over the pedal inputs without CPU involvement
+// and DMA streams the results into a ring that always holds the latest
+// PEDAL_ADC_OVERSAMPLING samples of every input. Reads sum those samples, so
+// they never block and are never older than the ring's window.
+
+// Samples summed per read, 16x oversampling gives 2 extra bits
+#define PEDAL_ADC_OVERSAMPLING 16
+#define PEDAL_ADC_RESOLUTION_BITS 14
+#define PEDAL_ADC_MAX_VALUE ((1 << PEDAL_ADC_RESOLUTION_BITS) - 1)
+
+// How often the whole ring is refreshed, i.e. the age of the oldest sample in a read
+#define PEDAL_ADC_WINDOW_HZ 1000
+
+// Initialises the pedal GPIOs, the ADC and DMA and starts converting.
+void pedal_adc_init(void);
+
+// Returns the oversampled value of the pedal on `pin`, between 0 and PEDAL_ADC_MAX_VALUE.
+uint16_t pedal_adc_read(uint8_t pin);
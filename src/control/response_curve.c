@@ -0,0 +1,50 @@
+#include "response_curve.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/helpers.h"
+#include "util/tank_assert.h"
+
+static float response_curve_piecewise(const response_curve_config_t* config, float x) {
+    TANK_ASSERT_M(config->n_points > 0 && config->n_points <= RESPONSE_CURVE_MAX_POINTS, "n_points = %u",
+                  config->n_points);
+    if (x <= config->points_x[0]) {
+        return config->points_y[0];
+    }
+    for (uint8_t i = 1; i < config->n_points; i++) {
+        if (x <= config->points_x[i]) {
+            const float x0 = config->points_x[i - 1];
+            const float y0 = config->points_y[i - 1];
+            const float span = config->points_x[i] - x0;
+            TANK_ASSERT_M(span > 0.0f, "Curve points must have increasing x");
+            return y0 + (config->points_y[i] - y0) * (x - x0) / span;
+        }
+    }
+    return config->points_y[config->n_points - 1];
+}
+
+static float response_curve_evaluate(const response_curve_config_t* config, float x) {
+    const float strength = MIN_OF(MAX_OF(config->strength, 0.0f), 1.0f);
+    switch ((response_curve_type_t)config->type) {
+        case RESPONSE_CURVE_LINEAR:
+            return x;
+        case RESPONSE_CURVE_EXPO:
+            return (1.0f - strength) * x + strength * x * x * x;
+        case RESPONSE_CURVE_S_CURVE:
+            return (1.0f - strength) * x + strength * x * x * (3.0f - 2.0f * x);
+        case RESPONSE_CURVE_PIECEWISE:
+            return response_curve_piecewise(config, x);
+    }
+    TANK_ASSERT_M(false, "Unexpected response_curve_type_t");
+    return x;
+}
+
+void response_curve_build(response_curve_t* curve, const response_curve_config_t* config) {
+    for (uint32_t i = 0; i <= RESPONSE_CURVE_LUT_SEGMENTS; i++) {
+        const float x = (float)i / (float)RESPONSE_CURVE_LUT_SEGMENTS;
+        const float y = response_curve_evaluate(config, x);
+        curve->lut[i] = q16_from_float(MIN_OF(MAX_OF(y, 0.0f), 1.0f));
+    }
+    curve->lut[RESPONSE_CURVE_LUT_SEGMENTS + 1] = curve->lut[RESPONSE_CURVE_LUT_SEGMENTS];
+}
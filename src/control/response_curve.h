@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "util/fixed.h"
+
+// Response curves reshape a Q16 input between Q16_ZERO and Q16_ONE. However a
+// curve is described it is compiled into a fixed size lookup table, so
+// evaluating it is always one lookup and one interpolation.
+
+typedef enum response_curve_type {
+    RESPONSE_CURVE_LINEAR,     // Output follows input
+    RESPONSE_CURVE_EXPO,       // Gentle around zero, steep near full input
+    RESPONSE_CURVE_S_CURVE,    // Gentle at both ends, steep in the middle
+    RESPONSE_CURVE_PIECEWISE,  // Straight lines between user points
+} response_curve_type_t;
+
+#define RESPONSE_CURVE_MAX_POINTS 8
+
+typedef struct response_curve_config {
+    uint8_t type;  // response_curve_type_t, fixed width so the layout matches on host tools
+
+    // RESPONSE_CURVE_EXPO and RESPONSE_CURVE_S_CURVE: how strong the curve is,
+    // 0.0 is linear and 1.0 is fully curved
+    float strength;
+
+    // RESPONSE_CURVE_PIECEWISE: points between 0.0 and 1.0 with increasing x.
+    // Inputs outside the points take the value of the nearest one.
+    uint8_t n_points;
+    float points_x[RESPONSE_CURVE_MAX_POINTS];
+    float points_y[RESPONSE_CURVE_MAX_POINTS];
+} response_curve_config_t;
+
+#define RESPONSE_CURVE_LUT_BITS 6
+#define RESPONSE_CURVE_LUT_SEGMENTS (1 << RESPONSE_CURVE_LUT_BITS)
+#define RESPONSE_CURVE_SEGMENT_BITS (Q16_FRACTIONAL_BITS - RESPONSE_CURVE_LUT_BITS)
+
+typedef struct response_curve {
+    // An entry for each segment start plus Q16_ONE, and a repeat of the last
+    // entry so Q16_ONE can interpolate without a special case
+    q16_t lut[RESPONSE_CURVE_LUT_SEGMENTS + 2];
+} response_curve_t;
+
+// Compiles `config` into `curve`. Uses float maths, so keep it off the hot path.
+void response_curve_build(response_curve_t* curve, const response_curve_config_t* config);
+
+static inline q16_t response_curve_apply(const response_curve_t* curve, q16_t input) {
+    const q16_t x = input < Q16_ZERO ? Q16_ZERO : (input > Q16_ONE ? Q16_ONE : input);
+    const uint32_t index = (uint32_t)x >> RESPONSE_CURVE_SEGMENT_BITS;
+    const int32_t fraction = x & ((1 << RESPONSE_CURVE_SEGMENT_BITS) - 1);
+    const int32_t start = curve->lut[index];
+    const int32_t delta = curve->lut[index + 1] - start;
+    return (q16_t)(start + ((delta * fraction) >> RESPONSE_CURVE_SEGMENT_BITS));
+}
@@ -0,0 +1,56 @@
+#include "tiller_predictor.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "types.h"
+#include "util/helpers.h"
+
+#define US_PER_S 1000000
+
+void tiller_predictor_init(tiller_predictor_t* predictor) {
+    predictor->position = 0;
+    predictor->velocity = 0;
+    predictor->last_update_us = 0;
+    predictor->initialised = false;
+}
+
+// Returns the position `dt_us` after the last measurement, assuming constant velocity
+static int64_t tiller_predictor_extrapolate(const tiller_predictor_t* predictor, uint32_t dt_us) {
+    return (int64_t)predictor->position + ((int64_t)predictor->velocity * dt_us) / US_PER_S;
+}
+
+void tiller_predictor_update(tiller_predictor_t* predictor, int32_t measurement, uint32_t timestamp_us) {
+    // Take the first measurement as is
+    const uint32_t dt_us = timestamp_us - predictor->last_update_us;
+    if (!predictor->initialised || 0 == dt_us || dt_us > TILLER_PREDICTOR_MAX_EXTRAPOLATION_US) {
+        predictor->position = measurement;
+        predictor->velocity = 0;
+        predictor->last_update_us = timestamp_us;
+        predictor->initialised = true;
+        return;
+    }
+
+    // Predict, then correct towards the measurement
+    const int64_t predicted = tiller_predictor_extrapolate(predictor, dt_us);
+    const int64_t residual = (int64_t)measurement - predicted;
+    const int64_t position = predicted + ((residual * TILLER_PREDICTOR_ALPHA_Q16) >> 16);
+    const int64_t velocity =
+        (int64_t)predictor->velocity + ((residual * TILLER_PREDICTOR_BETA_Q16 * US_PER_S / dt_us) >> 16);
+
+    predictor->position = (int32_t)position;
+    predictor->velocity = (int32_t)MAX_OF(MIN_OF(velocity, INT32_MAX), INT32_MIN);
+    predictor->last_update_us = timestamp_us;
+}
+
+int32_t tiller_predictor_estimate(const tiller_predictor_t* predictor, uint32_t now_us, uint32_t horizon_us) {
+    if (!predictor->initialised) {
+        return 0;
+    }
+
+    // Extrapolate from the last measurement, stopping once it is too old to trust
+    const uint32_t dt_us = MIN_OF((now_us - predictor->last_update_us) + horizon_us,
+                                  (uint32_t)TILLER_PREDICTOR_MAX_EXTRAPOLATION_US);
+    const int64_t estimate = tiller_predictor_extrapolate(predictor, dt_us);
+    return (int32_t)MAX_OF(MIN_OF(estimate, INPUT_RAW_TILLER_ABSOLUTE_MAX), INPUT_RAW_TILLER_ABSOLUTE_MIN);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Alpha-beta tracker for a single tiller, used to estimate the force between
+// HX710C conversions. All maths is integer, positions are raw tiller units.
+
+// Filter gains in Q16. Alpha weights the position correction, beta the velocity
+// correction. These are tuned for the 40 Hz HX710C conversion rate.
+#define TILLER_PREDICTOR_ALPHA_Q16 ((int32_t)(0.85 * 65536))
+#define TILLER_PREDICTOR_BETA_Q16 ((int32_t)(0.35 * 65536))
+
+// Upper limit on how far beyond the last measurement an estimate is
+// extrapolated, so a stalled sensor does not make the estimate run away.
+#define TILLER_PREDICTOR_MAX_EXTRAPOLATION_US 50000
+
+typedef struct tiller_predictor {
+    int32_t position;         // Raw tiller units, as of last_update_us
+    int32_t velocity;         // Raw tiller units per second
+    uint32_t last_update_us;  // Timestamp of the last measurement
+    bool initialised;
+} tiller_predictor_t;
+
+void tiller_predictor_init(tiller_predictor_t* predictor);
+
+// Corrects the tracker with a new measurement taken at `timestamp_us`.
+void tiller_predictor_update(tiller_predictor_t* predictor, int32_t measurement, uint32_t timestamp_us);
+
+// Estimates the tiller value `horizon_us` after `now_us`.
+int32_t tiller_predictor_estimate(const tiller_predictor_t* predictor, uint32_t now_us, uint32_t horizon_us);
@@ -0,0 +1,85 @@
+#include "tiller_task.h"
+
+#include <hardware/pio.h>
+#include <pico/time.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "hx710c.h"
+#include "pins.h"
+#include "portmacro.h"
+#include "projdefs.h"
+#include "task.h"
+
+// Stack info
+#define TILLER_TASK_STACK_SIZE 1024 / sizeof(StackType_t)
+static StackType_t tiller_task_stack[TILLER_TASK_STACK_SIZE];
+static StaticTask_t tiller_task_control_block;
+
+// Globals
+static TickType_t tiller_timeout = 0;
+static TaskHandle_t tiller_task_handle = NULL;
+static hx710c_t tiller_force_sensors;
+
+// Number of times the force sensors failed to produce a conversion in time
+static uint32_t tiller_misses = 0;
+
+// Latest sample, guarded by a critical section
+static tiller_sample_t tiller_latest_sample;
+static bool tiller_latest_sample_valid = false;
+
+// Wakes the tiller task as soon as the force sensors have a conversion ready
+static void tiller_force_sensors_ready(void* unused) {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(tiller_task_handle, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+static void tiller_task(void* unused) {
+    // Setup force sensors
+    const uint8_t force_sensor_sda_pins[] = {
+        LEFT_TILLER_SDA_PIN,
+        RIGHT_TILLER_SDA_PIN,
+    };
+    hx710c_init_pio(&tiller_force_sensors, pio0, TILLER_SCL_PIN, force_sensor_sda_pins, 2);
+    hx710c_set_ready_callback(&tiller_force_sensors, tiller_force_sensors_ready, NULL);
+
+    while (1) {
+        // Wait for the next conversion
+        ulTaskNotifyTake(pdTRUE, tiller_timeout);
+
+        // Read force sensors, the conversion has already been clocked out by PIO
+        int32_t conversions[2] = {0};
+        if (!hx710c_read(&tiller_force_sensors, conversions)) {
+            tiller_misses++;
+            continue;
+        }
+
+        // Publish
+        const tiller_sample_t sample = {
+            .left_tiller = conversions[0], .right_tiller = conversions[1], .timestamp_us = time_us_32()};
+        taskENTER_CRITICAL();
+        tiller_latest_sample = sample;
+        tiller_latest_sample_valid = true;
+        taskEXIT_CRITICAL();
+    }
+}
+
+void tiller_task_start(UBaseType_t priority, TickType_t timeout) {
+    tiller_timeout = timeout;
+    tiller_task_handle = xTaskCreateStatic(tiller_task, "Tiller Task", TILLER_TASK_STACK_SIZE, NULL, priority,
+                                           tiller_task_stack, &tiller_task_control_block);
+}
+
+bool tiller_task_get_latest(tiller_sample_t* sample) {
+    taskENTER_CRITICAL();
+    const bool valid = tiller_latest_sample_valid;
+    *sample = tiller_latest_sample;
+    taskEXIT_CRITICAL();
+    return valid;
+}
+
+uint32_t tiller_task_get_missed_samples(void) {
+    return tiller_misses + tiller_force_sensors.missed_conversions;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+// A tiller force reading along with when it was taken
+typedef struct tiller_sample {
+    int32_t left_tiller;   // Bound between INPUT_RAW_TILLER_ABSOLUTE_MIN / MAX
+    int32_t right_tiller;  // Bound between INPUT_RAW_TILLER_ABSOLUTE_MIN / MAX
+    uint32_t timestamp_us;
+} tiller_sample_t;
+
+// This task is responsible for acquiring the tiller force sensors at their
+// native conversion rate. It runs each time the force sensors have a
+// conversion ready, a conversion that has not arrived within `timeout` is
+// counted as missed.
+void tiller_task_start(UBaseType_t priority, TickType_t timeout);
+
+// Gets the latest tiller sample. Returns false if there has not been one yet.
+bool tiller_task_get_latest(tiller_sample_t* sample);
+
+// Returns the number of force sensor conversions that were late or never read.
+uint32_t tiller_task_get_missed_samples(void);
@@ -2,9 +2,14 @@
 
 #include <stdint.h>
 
+#include "auto_tare.h"
+#include "pedal_adc.h"
+#include "response_curve.h"
+#include "util/filter.h"
+
 // Raw input
 #define INPUT_RAW_PEDAL_ABSOLUTE_MIN ((uint16_t)0)
-#define INPUT_RAW_PEDAL_ABSOLUTE_MAX ((uint16_t)4095)
+#define INPUT_RAW_PEDAL_ABSOLUTE_MAX ((uint16_t)PEDAL_ADC_MAX_VALUE)
 
 // TODO verify tiller min and max values
 #define INPUT_RAW_TILLER_ABSOLUTE_MIN ((int32_t)-8388608)
@@ -18,6 +23,33 @@ typedef struct input_raw_report {
     int32_t right_tiller;  // Bound between INPUT_RAW_TILLER_ABSOLUTE_MIN / MAX
 } control_raw_report_t;
 
+// Raw channels, so mappings can declare which ones they consume
+typedef enum control_raw_channel {
+    CONTROL_RAW_ACCELERATOR,
+    CONTROL_RAW_BRAKE,
+    CONTROL_RAW_CLUTCH,
+    CONTROL_RAW_LEFT_TILLER,
+    CONTROL_RAW_RIGHT_TILLER,
+    CONTROL_RAW_N_CHANNELS,
+} control_raw_channel_t;
+
+// A set of control_raw_channel_t
+typedef uint32_t control_raw_channel_mask_t;
+#define CONTROL_RAW_CHANNEL_BIT(channel) ((control_raw_channel_mask_t)1 << (channel))
+#define CONTROL_RAW_ALL_CHANNELS (CONTROL_RAW_CHANNEL_BIT(CONTROL_RAW_N_CHANNELS) - 1)
+
+// When each acquisition path last produced the values in a control_raw_report_t
+typedef struct control_raw_timestamps {
+    uint32_t pedals_us;   // accelerator, brake and clutch
+    uint32_t tillers_us;  // left_tiller and right_tiller
+} control_raw_timestamps_t;
+
+// Where outputs go, games with analog input are better served by the gamepad
+typedef enum control_output_backend {
+    CONTROL_OUTPUT_KEYBOARD,  // Duty cycles modulated onto W, A, S, D and space
+    CONTROL_OUTPUT_GAMEPAD,   // Duty cycles as gamepad axes
+} control_output_backend_t;
+
 typedef struct input_output_map_config {
     // =========================================================================
     // Deadzones
@@ -43,4 +75,54 @@ typedef struct input_output_map_config {
     float tiller_handbrake_threshold_begin;
     float tiller_handbrake_threshold_end;
 
+    // How far ahead of the latest force sensor conversion the tillers are
+    // predicted, in microseconds. Hides part of the 40 Hz conversion latency.
+    // 0 only interpolates up to the present.
+    uint32_t tiller_prediction_horizon_us;
+
+    // =========================================================================
+    // Filtering
+    // =========================================================================
+
+    // Applied to each raw channel before it is scaled. Pedals are filtered at
+    // the input task rate, tillers at the force sensor conversion rate.
+    filter_config_t accelerator_filter;
+    filter_config_t brake_filter;
+    filter_config_t clutch_filter;
+    filter_config_t left_tiller_filter;
+    filter_config_t right_tiller_filter;
+
+    // =========================================================================
+    // Response curves
+    // =========================================================================
+
+    // Shape the pedal and turning outputs between their deadzone and full
+    // application
+    response_curve_config_t pedal_response_curve;
+    response_curve_config_t tiller_response_curve;
+
+    // =========================================================================
+    // Auto-tare
+    // =========================================================================
+
+    // Lets the tiller zeros follow load cell drift while the tillers rest
+    // below the deadzone
+    auto_tare_settings_t tiller_auto_tare;
+
+    // Minimum time between saving auto-tare corrections to flash
+    uint32_t auto_tare_save_interval_ms;
+
+    // =========================================================================
+    // Output
+    // =========================================================================
+
+    // Which USB interface the outputs drive, a control_output_backend_t. The
+    // other is held released.
+    uint8_t output_backend;
+
+    // How often the game samples the keyboard, in microseconds. Key presses
+    // are quantised to whole ticks so the game sees the requested duty cycle.
+    // 0 for games with no fixed tick, or when it is not known.
+    uint32_t consumer_tick_us;
+
 } control_settings_t;
\ No newline at end of file
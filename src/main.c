@@ -10,12 +10,14 @@
 #include "FreeRTOS.h"
 #include "config/config.h"
 #include "control/input_task.h"
+#include "control/tiller_task.h"
 #include "pins.h"
 #include "projdefs.h"
 #include "task.h"
 #include "terminal/terminal.h"
 #include "usb_keyboard/keyboard_task.h"
 #include "usb_keyboard/usb_task.h"
+#include "util/timing.h"
 
 #define STACK_SIZE 1024 * 8
 
@@ -48,10 +50,16 @@ int main(void) {
     // Stdio
     stdio_init_all();
 
+    // Derive busy wait timing from clk_sys, redo this if clk_sys is ever changed
+    timing_init();
+
     // Init tasks
     terminal_task_init();
     usb_task_init();
-    keyboard_task_init(pdMS_TO_TICKS(100));
+    // Presses and releases shorter than about a game frame can be missed, the game tick comes from the config
+    const key_modulator_config_t key_modulator_config = {
+        .min_press_us = 20000, .min_release_us = 20000, .consumer_tick_us = 0};
+    keyboard_task_init(&key_modulator_config);
     input_task_init();
 
     // Config
@@ -60,8 +68,9 @@ int main(void) {
     // Start tasks
     terminal_task_start(1, 1);
     usb_task_start(2, 1);
-    keyboard_task_start(4, pdMS_TO_TICKS(10));
-    input_task_start(3, pdMS_TO_TICKS(30));
+    keyboard_task_start(4, pdMS_TO_TICKS(50));  // Key transitions wake it, the interval only polls the engine switch
+    input_task_start(5, pdMS_TO_TICKS(1));
+    tiller_task_start(6, pdMS_TO_TICKS(30));  // Highest, so conversions are read as soon as they are ready
     xTaskCreateStatic(led_task, "", STACK_SIZE, NULL, 2, led_task_stack, &led_task_handle);
 
     // Start
@@ -2,12 +2,15 @@
 
 #include <hardware/uart.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "FreeRTOS.h"
 #include "pins.h"
 #include "portmacro.h"
 #include "semphr.h"
+#include "usb_keyboard/hid_transmit.h"
 #include "util/tank_assert.h"
 
 // Task info
@@ -65,7 +68,48 @@ void terminal_log(log_level_t log_level, const char* tag, const char* message, .
     TANK_ASSERT(pdTRUE == xSemaphoreGive(terminal_mutex_handle));
 }
 
+// Integer square root, rounded down
+static uint32_t terminal_sqrt(uint64_t value) {
+    uint64_t root = 0;
+    for (uint64_t bit = (uint64_t)1 << 62; 0 != bit; bit >>= 2) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+    }
+    return (uint32_t)root;
+}
+
+// Prints the report timing of each HID instance and starts a new measurement
+static void terminal_print_hid_stats(void) {
+    static const char* const instance_names[HID_N_INSTANCES] = {[HID_INSTANCE_KEYBOARD] = "keyboard",
+                                                                [HID_INSTANCE_GAMEPAD] = "gamepad"};
+    for (uint8_t instance = 0; instance < HID_N_INSTANCES; instance++) {
+        hid_transmit_stats_t stats;
+        hid_transmit_get_stats(instance, &stats);
+        if (0 == stats.reports) {
+            printf("%s: no reports, superseded: %lu\r\n", instance_names[instance], (unsigned long)stats.superseded);
+            continue;
+        }
+        // The rounded down mean squared never exceeds the mean square
+        const uint64_t mean_us = stats.latency_sum_us / stats.reports;
+        const uint64_t variance = stats.latency_sum_sq_us / stats.reports - mean_us * mean_us;
+        printf("%s: reports: %lu, superseded: %lu, latency us min: %lu, max: %lu, mean: %lu, std dev: %lu\r\n",
+               instance_names[instance], (unsigned long)stats.reports, (unsigned long)stats.superseded,
+               (unsigned long)stats.latency_min_us, (unsigned long)stats.latency_max_us, (unsigned long)mean_us,
+               (unsigned long)terminal_sqrt(variance));
+    }
+    hid_transmit_reset_stats();
+}
+
 void terminal_process_command(void) {
+    if (0 == strcmp(terminal_input, "hid_stats")) {
+        printf("\r\n");
+        terminal_print_hid_stats();
+        return;
+    }
     printf("Echoing input...\r\n");
     printf("%s\r\n", terminal_input);
 }
@@ -0,0 +1,36 @@
+#include "gamepad.h"
+
+#include <pico/time.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hid_transmit.h"
+#include "util/fixed.h"
+
+static_assert(sizeof(gamepad_report_t) <= HID_TRANSMIT_MAX_REPORT_SIZE, "gamepad report does not fit");
+
+static gamepad_report_t gamepad_last_report;  // Only touched by the caller of gamepad_set_output()
+
+static inline int32_t gamepad_axis(q16_t value) {
+    return (int32_t)(((int64_t)value * GAMEPAD_AXIS_MAX) >> Q16_FRACTIONAL_BITS);
+}
+
+gamepad_report_t gamepad_make_report(const keyboard_output_t* output, q16_t brake) {
+    const q16_t forward = q16_clamp(output->forward_duty_cycle, Q16_ZERO, Q16_ONE);
+    const q16_t left = q16_clamp(output->left_duty_cycle, Q16_ZERO, Q16_ONE);
+    const q16_t right = q16_clamp(output->right_duty_cycle, Q16_ZERO, Q16_ONE);
+    const q16_t hand_brake = q16_clamp(output->hand_brake_duty_cycle, Q16_ZERO, Q16_ONE);
+    return (gamepad_report_t){.steering = (int16_t)gamepad_axis(right - left),
+                              .throttle = (uint16_t)gamepad_axis(forward),
+                              .brake = (uint16_t)gamepad_axis(q16_clamp(brake, Q16_ZERO, Q16_ONE)),
+                              .hand_brake = (uint16_t)gamepad_axis(hand_brake)};
+}
+
+void gamepad_set_output(const keyboard_output_t* output, q16_t brake) {
+    const gamepad_report_t report = gamepad_make_report(output, brake);
+    if (0 == memcmp(&report, &gamepad_last_report, sizeof(gamepad_report_t))) {
+        return;
+    }
+    gamepad_last_report = report;
+    hid_transmit_stage(HID_INSTANCE_GAMEPAD, &report, sizeof(report), time_us_32());
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "types.h"
+
+// Analog alternative to the keyboard. The outputs go straight to gamepad axes
+// at their full resolution, with no modulation, so games with analog input
+// see them on the next USB frame.
+
+// Largest axis value, the steering axis also goes to its negative
+#define GAMEPAD_AXIS_MAX 32767
+
+typedef struct gamepad_report {
+    int16_t steering;     // Right less left, -GAMEPAD_AXIS_MAX to GAMEPAD_AXIS_MAX
+    uint16_t throttle;    // Forward, 0 to GAMEPAD_AXIS_MAX
+    uint16_t brake;       // Brake pedal, 0 to GAMEPAD_AXIS_MAX
+    uint16_t hand_brake;  // 0 to GAMEPAD_AXIS_MAX
+} gamepad_report_t;
+
+// Converts an output and the brake pedal application to a gamepad report.
+// The brake has no keyboard output, so it is passed on its own.
+gamepad_report_t gamepad_make_report(const keyboard_output_t* output, q16_t brake);
+
+// Sets the output and brake the gamepad reports. Only changes to the report
+// are sent. Call from one task only.
+void gamepad_set_output(const keyboard_output_t* output, q16_t brake);
@@ -0,0 +1,179 @@
+#include "hid_transmit.h"
+
+#include <pico/time.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "device/usbd_pvt.h"  // usbd_defer_func(), TinyUSB's only way to run code in the USB task
+#include "task.h"
+#include "tusb.h"
+#include "util/tank_assert.h"
+
+typedef struct hid_transmit_channel {
+    // Latest staged report, guarded by a critical section. A report is
+    // waiting while the staged sequence is ahead of the sent one.
+    uint8_t staged_report[HID_TRANSMIT_MAX_REPORT_SIZE];
+    uint16_t staged_size;
+    uint32_t staged_us;
+    uint32_t staged_sequence;
+    uint32_t sent_sequence;
+
+    // When the report on the wire was staged, only touched by the USB task
+    uint32_t in_flight_staged_us;
+
+    // Guarded by a critical section
+    hid_transmit_stats_t stats;
+} hid_transmit_channel_t;
+
+static hid_transmit_channel_t hid_transmit_channels[HID_N_INSTANCES] = {
+    [HID_INSTANCE_KEYBOARD] = {.stats = {.latency_min_us = UINT32_MAX}},
+    [HID_INSTANCE_GAMEPAD] = {.stats = {.latency_min_us = UINT32_MAX}},
+};
+
+// Set once start of frame events have been asked for, until tud_sof_cb() finds
+// nothing waiting. Guarded by a critical section, so a report staged while the
+// events are being turned off always asks for them again.
+static bool hid_transmit_sof_wanted = false;
+
+// Runs in the USB task, start of frame events are only wanted while a report is waiting
+static void hid_transmit_wake(void* unused) {
+    (void)unused;
+    tud_sof_cb_enable(true);
+}
+
+// Must be called in a critical section
+static bool hid_transmit_any_waiting(void) {
+    for (uint8_t instance = 0; instance < HID_N_INSTANCES; instance++) {
+        if (hid_transmit_channels[instance].staged_sequence != hid_transmit_channels[instance].sent_sequence) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void hid_transmit_stage(hid_instance_t instance, const void* report, uint16_t size, uint32_t staged_us) {
+    TANK_ASSERT(instance < HID_N_INSTANCES && size <= HID_TRANSMIT_MAX_REPORT_SIZE);
+    hid_transmit_channel_t* channel = &hid_transmit_channels[instance];
+
+    taskENTER_CRITICAL();
+    if (channel->staged_sequence != channel->sent_sequence) {
+        channel->stats.superseded++;
+    }
+    memcpy(channel->staged_report, report, size);
+    channel->staged_size = size;
+    channel->staged_us = staged_us;
+    channel->staged_sequence++;
+
+    // Until the host configures the device, and so before tusb_init(), the
+    // report is held and tud_mount_cb() asks for start of frame events
+    const bool wake = tud_mounted() && !hid_transmit_sof_wanted;
+    hid_transmit_sof_wanted |= wake;
+    taskEXIT_CRITICAL();
+
+    if (wake) {
+        usbd_defer_func(hid_transmit_wake, NULL, false);
+    }
+}
+
+void hid_transmit_stage_keyboard(const uint8_t key_codes[6], uint32_t staged_us) {
+    hid_keyboard_report_t report = {.modifier = 0, .reserved = 0};
+    memcpy(report.keycode, key_codes, sizeof(report.keycode));
+    hid_transmit_stage(HID_INSTANCE_KEYBOARD, &report, sizeof(report), staged_us);
+}
+
+// Sends the staged report of `instance` if there is one and its endpoint is
+// free. A report that could not be sent stays waiting for the next frame.
+static void hid_transmit_send(hid_instance_t instance) {
+    hid_transmit_channel_t* channel = &hid_transmit_channels[instance];
+    if (!tud_hid_n_ready(instance)) {
+        return;
+    }
+
+    uint8_t report[HID_TRANSMIT_MAX_REPORT_SIZE];
+    taskENTER_CRITICAL();
+    const uint32_t sequence = channel->staged_sequence;
+    const uint16_t size = channel->staged_size;
+    const uint32_t staged_us = channel->staged_us;
+    memcpy(report, channel->staged_report, size);
+    taskEXIT_CRITICAL();
+    if (sequence == channel->sent_sequence || !tud_hid_n_report(instance, 0, report, size)) {
+        return;
+    }
+    channel->in_flight_staged_us = staged_us;
+    taskENTER_CRITICAL();
+    channel->sent_sequence = sequence;
+    taskEXIT_CRITICAL();
+}
+
+void tud_sof_cb(uint32_t frame_count) {
+    (void)frame_count;
+    for (uint8_t instance = 0; instance < HID_N_INSTANCES; instance++) {
+        hid_transmit_send(instance);
+    }
+
+    // Checked again as a whole, a report may have been staged since its instance was sent
+    taskENTER_CRITICAL();
+    const bool waiting = hid_transmit_any_waiting();
+    hid_transmit_sof_wanted = waiting;
+    taskEXIT_CRITICAL();
+    if (!waiting) {
+        tud_sof_cb_enable(false);
+    }
+}
+
+void tud_mount_cb(void) {
+    // Send anything staged before the host configured the device
+    taskENTER_CRITICAL();
+    const bool wake = hid_transmit_any_waiting() && !hid_transmit_sof_wanted;
+    hid_transmit_sof_wanted |= wake;
+    taskEXIT_CRITICAL();
+    if (wake) {
+        tud_sof_cb_enable(true);
+    }
+}
+
+void tud_umount_cb(void) {
+    // Start of frame events may not survive a bus reset, ask for them again on the next mount
+    taskENTER_CRITICAL();
+    hid_transmit_sof_wanted = false;
+    taskEXIT_CRITICAL();
+}
+
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len) {
+    (void)report;
+    (void)len;
+    if (instance >= HID_N_INSTANCES) {
+        return;
+    }
+    hid_transmit_channel_t* channel = &hid_transmit_channels[instance];
+
+    const uint32_t latency_us = time_us_32() - channel->in_flight_staged_us;
+    taskENTER_CRITICAL();
+    hid_transmit_stats_t* stats = &channel->stats;
+    stats->reports++;
+    stats->latency_min_us = latency_us < stats->latency_min_us ? latency_us : stats->latency_min_us;
+    stats->latency_max_us = latency_us > stats->latency_max_us ? latency_us : stats->latency_max_us;
+    stats->latency_sum_us += latency_us;
+    stats->latency_sum_sq_us += (uint64_t)latency_us * latency_us;
+    taskEXIT_CRITICAL();
+
+    // Stage the next report straight away, it goes out on the next poll
+    hid_transmit_send(instance);
+}
+
+void hid_transmit_get_stats(hid_instance_t instance, hid_transmit_stats_t* stats) {
+    TANK_ASSERT(instance < HID_N_INSTANCES);
+    taskENTER_CRITICAL();
+    *stats = hid_transmit_channels[instance].stats;
+    taskEXIT_CRITICAL();
+}
+
+void hid_transmit_reset_stats(void) {
+    taskENTER_CRITICAL();
+    for (uint8_t instance = 0; instance < HID_N_INSTANCES; instance++) {
+        hid_transmit_channels[instance].stats = (hid_transmit_stats_t){.latency_min_us = UINT32_MAX};
+    }
+    taskEXIT_CRITICAL();
+}
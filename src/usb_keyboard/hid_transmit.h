@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+// Reports are staged here and sent from the USB task. A staged report goes
+// out on the next start of frame if its endpoint is free, or as soon as the
+// report before it completes, so reports leave on the host's 1 ms frame
+// boundaries without any timer polling. Start of frame events are only
+// enabled while a report is waiting. Reports staged before the host has
+// configured the device are held, and the latest of each goes out on mount.
+
+// HID interfaces of the composite device, in configuration descriptor order
+typedef enum hid_instance {
+    HID_INSTANCE_KEYBOARD,
+    HID_INSTANCE_GAMEPAD,
+    HID_N_INSTANCES,
+} hid_instance_t;
+
+// Largest report any instance sends
+#define HID_TRANSMIT_MAX_REPORT_SIZE 8
+
+// Timing of reports from being staged to the host taking them
+typedef struct hid_transmit_stats {
+    uint32_t reports;            // Reports the host has taken
+    uint32_t superseded;         // Staged reports replaced by a newer one before they were sent
+    uint32_t latency_min_us;     // Shortest time from staging to the host taking the report
+    uint32_t latency_max_us;     // Longest, the jitter is the spread between the two
+    uint64_t latency_sum_us;     // For the mean
+    uint64_t latency_sum_sq_us;  // For the standard deviation, in microseconds squared
+} hid_transmit_stats_t;
+
+// Stages the report to send next on `instance`, replacing any staged report
+// that has not gone yet. `staged_us` is when the report changed, from
+// time_us_32(). Safe to call from any task, before or after tusb_init().
+void hid_transmit_stage(hid_instance_t instance, const void* report, uint16_t size, uint32_t staged_us);
+
+// Stages a boot keyboard report holding `key_codes`.
+void hid_transmit_stage_keyboard(const uint8_t key_codes[6], uint32_t staged_us);
+
+// Gets the report timing of `instance` since the last reset. The terminal's
+// hid_stats command prints these and resets them.
+void hid_transmit_get_stats(hid_instance_t instance, hid_transmit_stats_t* stats);
+
+// Clears the report timing of every instance.
+void hid_transmit_reset_stats(void);
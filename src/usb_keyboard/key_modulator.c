@@ -0,0 +1,169 @@
+#include "key_modulator.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Longest a quantised next toggle is looked for, in ticks
+#define KEY_MODULATOR_MAX_LOOKAHEAD_TICKS 64
+
+// Longest gap between quantised updates that is caught up tick by tick, beyond
+// it the grid skips ahead
+#define KEY_MODULATOR_MAX_CATCH_UP_TICKS 256
+
+void key_modulator_init(key_modulator_t* modulator) {
+    memset(modulator, 0, sizeof(key_modulator_t));
+}
+
+// Shortest press, or release, when quantised rounded up to whole ticks, as the
+// game sees no less and every state lasts at least one tick
+static uint32_t key_modulator_min_width_us(const key_modulator_config_t* config, bool pressed) {
+    const uint32_t width_us = pressed ? config->min_press_us : config->min_release_us;
+    const uint32_t tick_us = config->consumer_tick_us;
+    if (0 == tick_us) {
+        return width_us;
+    }
+    return width_us <= tick_us ? tick_us : (width_us - 1) / tick_us * tick_us + tick_us;
+}
+
+// Integrates `elapsed_us` at `duty`, then toggles at `at_us` if the error and
+// the minimum widths allow
+static void key_modulator_step(key_modulator_t* modulator,
+                               const key_modulator_config_t* config,
+                               q16_t duty,
+                               uint32_t at_us,
+                               uint32_t elapsed_us) {
+    // The key was held, or not, for the whole of the last interval
+    const q16_t held = modulator->pressed ? Q16_ONE : Q16_ZERO;
+    modulator->error += (int64_t)(duty - held) * elapsed_us;
+
+    // Bound the error, so a step in the target is not held back by debt from
+    // the old one. Quantised, the error only outgrows a tick while a minimum
+    // width holds the key, so the longer width bounds it. Otherwise allow about
+    // one press and release.
+    const uint32_t min_press_us = key_modulator_min_width_us(config, true);
+    const uint32_t min_release_us = key_modulator_min_width_us(config, false);
+    int64_t limit;
+    if (0 != config->consumer_tick_us) {
+        limit = (int64_t)Q16_ONE * (min_press_us > min_release_us ? min_press_us : min_release_us);
+    } else {
+        limit = (int64_t)Q16_ONE * ((int64_t)min_press_us + min_release_us + elapsed_us);
+    }
+    modulator->error = modulator->error > limit ? limit : (modulator->error < -limit ? -limit : modulator->error);
+
+    // The ends are exact, with no debt carried out of them
+    bool press = modulator->error > 0;
+    if (Q16_ZERO == duty || Q16_ONE == duty) {
+        press = Q16_ONE == duty;
+        modulator->error = 0;
+    }
+
+    // Toggle once the current state has lasted long enough to register
+    const uint32_t state_us = at_us - modulator->last_toggle_us;
+    const uint32_t min_state_us = modulator->pressed ? min_press_us : min_release_us;
+    if (press != modulator->pressed && state_us >= min_state_us) {
+        modulator->pressed = press;
+        modulator->last_toggle_us = at_us;
+    }
+}
+
+// Runs a step at every tick boundary up to `now_us`
+static void key_modulator_catch_up(key_modulator_t* modulator, const key_modulator_config_t* config, uint32_t now_us) {
+    const uint32_t tick_us = config->consumer_tick_us;
+    const int32_t behind_us = (int32_t)(now_us - modulator->next_edge_us);
+    if ((int64_t)behind_us > (int64_t)KEY_MODULATOR_MAX_CATCH_UP_TICKS * tick_us) {
+        // Long asleep, keep the grid but not the history
+        modulator->next_edge_us += (uint32_t)behind_us / tick_us * tick_us;
+        modulator->error = 0;
+    }
+    while ((int32_t)(now_us - modulator->next_edge_us) >= 0) {
+        key_modulator_step(modulator, config, modulator->duty_cycle, modulator->next_edge_us, tick_us);
+        modulator->next_edge_us += tick_us;
+    }
+}
+
+bool key_modulator_update(key_modulator_t* modulator,
+                          const key_modulator_config_t* config,
+                          q16_t duty_cycle,
+                          uint32_t now_us) {
+    const q16_t duty = q16_clamp(duty_cycle, Q16_ZERO, Q16_ONE);
+    if (!modulator->started) {
+        // Released for long enough already, so the first press is not held back
+        modulator->last_update_us = now_us;
+        modulator->last_toggle_us = now_us - key_modulator_min_width_us(config, false);
+        modulator->next_edge_us = now_us + config->consumer_tick_us;
+        modulator->duty_cycle = duty;
+        modulator->started = true;
+    }
+
+    if (0 != config->consumer_tick_us) {
+        // Ticks that ended before now ran at the old target, the new one starts with the next
+        key_modulator_catch_up(modulator, config, now_us);
+        modulator->duty_cycle = duty;
+        modulator->last_update_us = now_us;
+        return modulator->pressed;
+    }
+
+    const uint32_t elapsed_us = now_us - modulator->last_update_us;
+    modulator->last_update_us = now_us;
+    key_modulator_step(modulator, config, duty, now_us, elapsed_us);
+    return modulator->pressed;
+}
+
+// Steps a copy of the modulator one tick at a time until it toggles
+static bool key_modulator_next_quantised_toggle(const key_modulator_t* modulator,
+                                                const key_modulator_config_t* config,
+                                                q16_t duty,
+                                                uint32_t* toggle_us) {
+    if ((modulator->pressed && Q16_ONE == duty) || (!modulator->pressed && Q16_ZERO == duty)) {
+        return false;
+    }
+    key_modulator_t ahead = *modulator;
+    for (uint32_t tick = 0; tick < KEY_MODULATOR_MAX_LOOKAHEAD_TICKS; tick++) {
+        const uint32_t edge_us = ahead.next_edge_us;
+        key_modulator_step(&ahead, config, duty, edge_us, config->consumer_tick_us);
+        ahead.next_edge_us += config->consumer_tick_us;
+        if (ahead.pressed != modulator->pressed) {
+            *toggle_us = edge_us;
+            return true;
+        }
+    }
+    *toggle_us = ahead.next_edge_us;  // Check again from there
+    return true;
+}
+
+bool key_modulator_next_toggle(const key_modulator_t* modulator,
+                               const key_modulator_config_t* config,
+                               q16_t duty_cycle,
+                               uint32_t* toggle_us) {
+    const q16_t duty = q16_clamp(duty_cycle, Q16_ZERO, Q16_ONE);
+    if (0 != config->consumer_tick_us) {
+        return key_modulator_next_quantised_toggle(modulator, config, duty, toggle_us);
+    }
+
+    // Time until the error changes sign, it falls at 1 - duty while pressed and rises at duty while released
+    int64_t after_us;
+    if (modulator->pressed) {
+        if (Q16_ONE == duty) {
+            return false;
+        }
+        const int64_t rate = Q16_ONE - duty;
+        after_us = modulator->error <= 0 ? 0 : (modulator->error + rate - 1) / rate;
+    } else {
+        if (Q16_ZERO == duty) {
+            return false;
+        }
+        after_us = modulator->error > 0 ? 0 : -modulator->error / duty + 1;
+    }
+
+    // No sooner than the current state has lasted long enough to register
+    const uint32_t state_us = modulator->last_update_us - modulator->last_toggle_us;
+    const uint32_t min_state_us = modulator->pressed ? config->min_press_us : config->min_release_us;
+    if (state_us + after_us < min_state_us) {
+        after_us = min_state_us - state_us;
+    }
+    after_us = after_us < 1 ? 1 : (after_us > INT32_MAX ? INT32_MAX : after_us);
+
+    *toggle_us = modulator->last_update_us + (uint32_t)after_us;
+    return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/fixed.h"
+
+// First order sigma-delta modulation of a key from a duty cycle. The error
+// between the target duty cycle and the time the key has actually been held is
+// integrated, and the key toggles whenever the error changes sign. A new duty
+// cycle takes effect from the next update, and presses are spread evenly in
+// time rather than lumped at the start of a PWM period.
+//
+// A game that samples the keyboard once per simulation tick only sees presses
+// to the nearest tick, so presses of arbitrary length alias into a different
+// duty cycle. Given the game's tick, the modulator runs once per tick instead
+// and only toggles on a fixed grid of tick boundaries. Every press and release
+// then spans a whole number of ticks, which the game sees as exactly that many
+// samples whatever the phase of its ticks against ours. The grid keeps its
+// phase from the first update, so the spacing of edges never drifts. The
+// minimum widths round up to whole ticks, and the time the key has been held
+// stays within the longer of them of the target.
+
+typedef struct key_modulator_config {
+    uint32_t min_press_us;      // Shortest press, so the game sees every one
+    uint32_t min_release_us;    // Shortest gap between presses, so the game sees every release
+    uint32_t consumer_tick_us;  // Game tick to quantise presses to, 0 to not quantise
+} key_modulator_config_t;
+
+typedef struct key_modulator {
+    int64_t error;  // Q16 microseconds of press owed, negative when the key has been held too long
+    uint32_t last_update_us;
+    uint32_t last_toggle_us;
+    uint32_t next_edge_us;  // Next tick boundary, when quantised
+    q16_t duty_cycle;       // Target until the next tick boundary, when quantised
+    bool pressed;
+    bool started;
+} key_modulator_t;
+
+void key_modulator_init(key_modulator_t* modulator);
+
+// Advances the modulator to `now_us` and sets its target to `duty_cycle`.
+// Returns whether the key is held until the next update. The config must not
+// change between updates without an init.
+bool key_modulator_update(key_modulator_t* modulator,
+                          const key_modulator_config_t* config,
+                          q16_t duty_cycle,
+                          uint32_t now_us);
+
+// Finds when the key will next toggle if `duty_cycle` is held from the last
+// update, so the caller can sleep until then rather than poll. Returns false
+// if the key will stay as it is, otherwise sets `toggle_us`, which is always
+// after the last update. When quantised it may return a tick boundary short
+// of the toggle if that is far off.
+bool key_modulator_next_toggle(const key_modulator_t* modulator,
+                               const key_modulator_config_t* config,
+                               q16_t duty_cycle,
+                               uint32_t* toggle_us);
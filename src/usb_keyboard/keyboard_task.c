@@ -1,45 +1,72 @@
 #include "keyboard_task.h"
 
 #include <hardware/gpio.h>
+#include <pico/time.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "FreeRTOS.h"
-#include "class/hid/hid_device.h"
+#include "hid_transmit.h"
+#include "key_modulator.h"
 #include "pins.h"
 #include "portmacro.h"
 #include "projdefs.h"
 #include "queue.h"
 #include "scan_codes.h"
 #include "task.h"
+#include "util/fixed.h"
 
 // Task
 #define KEYBOARD_TASK_STACK_SIZE (1024) / sizeof(StackType_t)
 static StackType_t reporter_task_stack[KEYBOARD_TASK_STACK_SIZE];
 static StaticTask_t reporter_task_control_block;
+static TaskHandle_t keyboard_task_handle = NULL;
 TickType_t keyboard_interval = 0;
 
+// Wakes the task at the next key transition
+static alarm_id_t keyboard_transition_alarm = 0;
+
 // Queue
 static QueueHandle_t keyboard_queue_handle;
 static StaticQueue_t keyboard_queue_control_block;
 static uint8_t queue_storage[sizeof(keyboard_output_t)];
+static keyboard_output_t keyboard_last_set_output;  // Only touched by the caller of keyboard_task_set_output()
 
 // Report
-static keyboard_output_t current_keyboard_output = {.forward_duty_cycle = 0.0,
-                                                    .left_duty_cycle = 0.0,
-                                                    .right_duty_cycle = 0.0,
-                                                    .reverse_duty_cycle = 0.0,
-                                                    .hand_brake_duty_cycle = 0.0};
-
-// PWM
-TickType_t reporter_pwm_period;
+static keyboard_output_t current_keyboard_output = {.forward_duty_cycle = Q16_ZERO,
+                                                    .left_duty_cycle = Q16_ZERO,
+                                                    .right_duty_cycle = Q16_ZERO,
+                                                    .reverse_duty_cycle = Q16_ZERO,
+                                                    .hand_brake_duty_cycle = Q16_ZERO};
+
+// Modulation
+static key_modulator_config_t reporter_modulator_config;
+static uint32_t keyboard_pending_consumer_tick_us = 0;  // Guarded by a critical section
+static key_modulator_t forward_modulator;
+static key_modulator_t left_modulator;
+static key_modulator_t right_modulator;
+static key_modulator_t reverse_modulator;
+static key_modulator_t hand_brake_modulator;
 const uint32_t reporter_max_reports_before_reset_attempt = 1000;
 
-void keyboard_task_init(TickType_t pwm_period) {
-    // Set up PWM
-    reporter_pwm_period = pwm_period;
+// Most keys a boot keyboard report can hold
+#define KEYBOARD_MAX_KEYS 6
+
+static void keyboard_modulators_init(void) {
+    key_modulator_init(&forward_modulator);
+    key_modulator_init(&left_modulator);
+    key_modulator_init(&right_modulator);
+    key_modulator_init(&reverse_modulator);
+    key_modulator_init(&hand_brake_modulator);
+}
+
+void keyboard_task_init(const key_modulator_config_t* modulator_config) {
+    // Set up modulation
+    reporter_modulator_config = *modulator_config;
+    keyboard_pending_consumer_tick_us = modulator_config->consumer_tick_us;
+    keyboard_modulators_init();
 
     // Set up queue
     keyboard_queue_handle =
@@ -52,93 +79,170 @@ void keyboard_task_init(TickType_t pwm_period) {
 }
 
 void keyboard_task_set_output(const keyboard_output_t* command) {
+    // Only wake the task for outputs that change something
+    if (0 == memcmp(command, &keyboard_last_set_output, sizeof(keyboard_output_t))) {
+        return;
+    }
+    keyboard_last_set_output = *command;
     xQueueOverwrite(keyboard_queue_handle, command);
+    if (NULL != keyboard_task_handle) {
+        xTaskNotifyGive(keyboard_task_handle);
+    }
+}
+
+void keyboard_task_set_consumer_tick(uint32_t consumer_tick_us) {
+    taskENTER_CRITICAL();
+    const bool changed = consumer_tick_us != keyboard_pending_consumer_tick_us;
+    keyboard_pending_consumer_tick_us = consumer_tick_us;
+    taskEXIT_CRITICAL();
+    if (changed && NULL != keyboard_task_handle) {
+        xTaskNotifyGive(keyboard_task_handle);
+    }
+}
+
+static int64_t keyboard_transition_due(alarm_id_t id, void* unused) {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(keyboard_task_handle, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+    return 0;  // One shot, the task arms the next
 }
 
 static void keyboard_send_report() {}
 
+// Advances the modulator for a key and adds the key if it is held
+static inline void keyboard_modulate_key(key_modulator_t* modulator,
+                                         q16_t duty_cycle,
+                                         uint32_t now_us,
+                                         uint8_t scan_code,
+                                         uint8_t key_codes[KEYBOARD_MAX_KEYS],
+                                         uint8_t* key_codes_added) {
+    if (key_modulator_update(modulator, &reporter_modulator_config, duty_cycle, now_us)) {
+        key_codes[*key_codes_added] = scan_code;
+        (*key_codes_added)++;
+    }
+}
+
+// Keeps the soonest transition of a key, in microseconds from `now_us`
+static inline void keyboard_next_transition(const key_modulator_t* modulator,
+                                            q16_t duty_cycle,
+                                            uint32_t now_us,
+                                            uint32_t* soonest_us) {
+    uint32_t toggle_us;
+    if (key_modulator_next_toggle(modulator, &reporter_modulator_config, duty_cycle, &toggle_us)) {
+        const int32_t until_us = (int32_t)(toggle_us - now_us);
+        const uint32_t wait_us = until_us < 1 ? 1 : (uint32_t)until_us;
+        *soonest_us = wait_us < *soonest_us ? wait_us : *soonest_us;
+    }
+}
+
+// Arms the alarm for the next key transition, returns how long the task may sleep
+static TickType_t keyboard_schedule_transition(uint32_t now_us) {
+    if (0 < keyboard_transition_alarm) {
+        cancel_alarm(keyboard_transition_alarm);
+        keyboard_transition_alarm = 0;
+    }
+
+    uint32_t soonest_us = UINT32_MAX;
+    keyboard_next_transition(&forward_modulator, current_keyboard_output.forward_duty_cycle, now_us, &soonest_us);
+    keyboard_next_transition(&left_modulator, current_keyboard_output.left_duty_cycle, now_us, &soonest_us);
+    keyboard_next_transition(&right_modulator, current_keyboard_output.right_duty_cycle, now_us, &soonest_us);
+    keyboard_next_transition(&reverse_modulator, current_keyboard_output.reverse_duty_cycle, now_us, &soonest_us);
+    keyboard_next_transition(&hand_brake_modulator, current_keyboard_output.hand_brake_duty_cycle, now_us,
+                             &soonest_us);
+    if (UINT32_MAX == soonest_us) {
+        return keyboard_interval;  // Every key stays as it is until the output changes
+    }
+
+    // Measured from now rather than when the task woke, a late wake only delays this transition
+    const uint32_t late_us = time_us_32() - now_us;
+    if (soonest_us <= late_us) {
+        return 0;
+    }
+    keyboard_transition_alarm = add_alarm_in_us(soonest_us - late_us, keyboard_transition_due, NULL, false);
+    if (0 == keyboard_transition_alarm) {
+        return 0;  // Came due while arming
+    }
+    if (0 > keyboard_transition_alarm) {
+        return 1;  // No alarm free, fall back to the tick
+    }
+    return keyboard_interval;
+}
+
 static void keyboard_task(void* unused) {
     vTaskDelay(1000);
 
-    TickType_t wake_time = xTaskGetTickCount();
-    TickType_t period_start = wake_time;
+    // Keys last handed to the USB task
+    uint8_t staged_key_codes[KEYBOARD_MAX_KEYS] = {0x00};
+    uint32_t n_reports_sent = 0;
+    TickType_t timeout = keyboard_interval;
 
     while (1) {
-        uint32_t n_reports_sent = 0;
-        if (tud_hid_ready()) {
-            // Determine how far we are through the period and start new periods
-            const TickType_t current_tick = xTaskGetTickCount();
-            TickType_t elapsed = current_tick - period_start;
-            if (elapsed > reporter_pwm_period) {
-                period_start = current_tick;
-                elapsed = 0;
-                keyboard_output_t new_report;
-                if (pdPASS == xQueueReceive(keyboard_queue_handle, &new_report, 0)) {
-                    current_keyboard_output = new_report;
-                }
-            }
-            const float elapsed_fraction = (float)elapsed / (float)reporter_pwm_period;
-            TANK_ASSERT_M(elapsed_fraction <= 1.0 && elapsed_fraction >= 0.0, "elapsed_fraction = %f",
-                          elapsed_fraction);
-
-            // Create HID report
-            uint8_t key_codes[6] = {0x00};
-            uint8_t key_codes_added = 0;
-
-            if (elapsed_fraction <= current_keyboard_output.forward_duty_cycle &&
-                current_keyboard_output.forward_duty_cycle != 0.0) {
-                key_codes[key_codes_added] = SCAN_CODE_W;
-                key_codes_added++;
-            }
-            if (elapsed_fraction <= current_keyboard_output.left_duty_cycle &&
-                current_keyboard_output.left_duty_cycle != 0.0) {
-                key_codes[key_codes_added] = SCAN_CODE_A;
-                key_codes_added++;
-            }
-            if (elapsed_fraction <= current_keyboard_output.right_duty_cycle &&
-                current_keyboard_output.right_duty_cycle != 0.0) {
-                key_codes[key_codes_added] = SCAN_CODE_D;
-                key_codes_added++;
-            }
-            if (elapsed_fraction <= current_keyboard_output.reverse_duty_cycle &&
-                current_keyboard_output.reverse_duty_cycle != 0.0) {
-                key_codes[key_codes_added] = SCAN_CODE_S;
-                key_codes_added++;
-            }
-            if (elapsed_fraction <= current_keyboard_output.hand_brake_duty_cycle &&
-                current_keyboard_output.hand_brake_duty_cycle != 0.0) {
-                key_codes[key_codes_added] = SCAN_CODE_SPACEBAR;
-                key_codes_added++;
-            }
-
-            // Clear report if the engine is disabled
-            if (!gpio_get(ENGINE_ON_OFF_SWITCH_PIN)) {
-                memset(key_codes, 0, 6);
-                key_codes_added = 0;
-            }
-
-            // // Clear the report if it time to send a reset
-            // if (reporter_max_reports_before_reset_attempt <= n_reports_sent) {
-            //     // Every N reports send an empty one to unfuck stuck keys
-            //     uint8_t zeros[8] = {0};
-            //     n_reports_sent = 0;
-            //     memset(key_codes, 0, 6);
-            //     key_codes_added = 0;
-            // }
-
-            // TODO send any single shot keys
-
-            // Send report
-            tud_hid_keyboard_report(0, 0, key_codes);
+        // Sleep until a key transition, a new output or, at the latest, the next engine switch check
+        ulTaskNotifyTake(pdTRUE, timeout);
+
+        // A new game tick starts the modulators over on a new grid
+        taskENTER_CRITICAL();
+        const uint32_t consumer_tick_us = keyboard_pending_consumer_tick_us;
+        taskEXIT_CRITICAL();
+        if (consumer_tick_us != reporter_modulator_config.consumer_tick_us) {
+            reporter_modulator_config.consumer_tick_us = consumer_tick_us;
+            keyboard_modulators_init();
+        }
+
+        // Take up new outputs straight away, the modulators carry on from where they were
+        keyboard_output_t new_report;
+        if (pdPASS == xQueueReceive(keyboard_queue_handle, &new_report, 0)) {
+            current_keyboard_output = new_report;
+        }
+
+        // Create HID report
+        const uint32_t now_us = time_us_32();
+        uint8_t key_codes[KEYBOARD_MAX_KEYS] = {0x00};
+        uint8_t key_codes_added = 0;
+        keyboard_modulate_key(&forward_modulator, current_keyboard_output.forward_duty_cycle, now_us, SCAN_CODE_W,
+                              key_codes, &key_codes_added);
+        keyboard_modulate_key(&left_modulator, current_keyboard_output.left_duty_cycle, now_us, SCAN_CODE_A, key_codes,
+                              &key_codes_added);
+        keyboard_modulate_key(&right_modulator, current_keyboard_output.right_duty_cycle, now_us, SCAN_CODE_D,
+                              key_codes, &key_codes_added);
+        keyboard_modulate_key(&reverse_modulator, current_keyboard_output.reverse_duty_cycle, now_us, SCAN_CODE_S,
+                              key_codes, &key_codes_added);
+        keyboard_modulate_key(&hand_brake_modulator, current_keyboard_output.hand_brake_duty_cycle, now_us,
+                              SCAN_CODE_SPACEBAR, key_codes, &key_codes_added);
+
+        // Clear report if the engine is disabled, no transitions are scheduled while it is
+        const bool engine_on = gpio_get(ENGINE_ON_OFF_SWITCH_PIN);
+        if (!engine_on) {
+            memset(key_codes, 0, 6);
+            key_codes_added = 0;
+        }
+
+        // // Clear the report if it time to send a reset
+        // if (reporter_max_reports_before_reset_attempt <= n_reports_sent) {
+        //     // Every N reports send an empty one to unfuck stuck keys
+        //     uint8_t zeros[8] = {0};
+        //     n_reports_sent = 0;
+        //     memset(key_codes, 0, 6);
+        //     key_codes_added = 0;
+        // }
+
+        // TODO send any single shot keys
+
+        // Stage a report, only when a key has changed, the USB task sends it on the next frame
+        if (0 != memcmp(key_codes, staged_key_codes, sizeof(staged_key_codes))) {
+            hid_transmit_stage_keyboard(key_codes, now_us);
+            memcpy(staged_key_codes, key_codes, sizeof(staged_key_codes));
             n_reports_sent++;
         }
-        vTaskDelayUntil(&wake_time, keyboard_interval);
+
+        // Sleep until the next transition
+        timeout = engine_on ? keyboard_schedule_transition(now_us) : keyboard_interval;
     }
 }
 
 // Starts the reporter task.
 void keyboard_task_start(UBaseType_t priority, TickType_t interval) {
     keyboard_interval = interval;
-    xTaskCreateStatic(keyboard_task, "Keyboard Task", KEYBOARD_TASK_STACK_SIZE, NULL, priority, reporter_task_stack,
-                      &reporter_task_control_block);
+    keyboard_task_handle = xTaskCreateStatic(keyboard_task, "Keyboard Task", KEYBOARD_TASK_STACK_SIZE, NULL, priority,
+                                             reporter_task_stack, &reporter_task_control_block);
 }
@@ -4,15 +4,22 @@
 #include <stdint.h>
 
 #include "FreeRTOS.h"
+#include "key_modulator.h"
 #include "portmacro.h"
 #include "types.h"
 
-// Init the keyboard task
-void keyboard_task_init(TickType_t pwm_period);
+// Init the keyboard task, keys are modulated within the limits of `modulator_config`
+void keyboard_task_init(const key_modulator_config_t* modulator_config);
 
 // This task is responsible for sending keyboard reports.
-// Keyboard reports describe how "keyboard" buttons wil be pressed.
+// Keyboard reports describe how "keyboard" buttons wil be pressed. Reports are
+// only staged when a key changes and are sent by the USB task, see
+// hid_transmit.h. The task sleeps until the next key transition on a hardware
+// alarm and checks the engine switch at least every `interval`.
 void keyboard_task_start(UBaseType_t priority, TickType_t interval);
 
 // Sets the keyboard output that will be sent.
-void keyboard_task_set_output(const keyboard_output_t* command);
\ No newline at end of file
+void keyboard_task_set_output(const keyboard_output_t* command);
+
+// Sets the game tick presses are quantised to, 0 to not quantise. See key_modulator.h.
+void keyboard_task_set_consumer_tick(uint32_t consumer_tick_us);
\ No newline at end of file
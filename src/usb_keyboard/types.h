@@ -1,9 +1,11 @@
 #pragma once
 
+#include "util/fixed.h"
+
 typedef struct keyboard_output {
-    float forward_duty_cycle;     // Bound between 0.0 and 1.0
-    float left_duty_cycle;        // Bound between 0.0 and 1.0
-    float right_duty_cycle;       // Bound between 0.0 and 1.0
-    float reverse_duty_cycle;     // Bound between 0.0 and 1.0
-    float hand_brake_duty_cycle;  // Bound between 0.0 and 1.0
+    q16_t forward_duty_cycle;     // Bound between Q16_ZERO and Q16_ONE
+    q16_t left_duty_cycle;        // Bound between Q16_ZERO and Q16_ONE
+    q16_t right_duty_cycle;       // Bound between Q16_ZERO and Q16_ONE
+    q16_t reverse_duty_cycle;     // Bound between Q16_ZERO and Q16_ONE
+    q16_t hand_brake_duty_cycle;  // Bound between Q16_ZERO and Q16_ONE
 } keyboard_output_t;
\ No newline at end of file
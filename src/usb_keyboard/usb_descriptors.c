@@ -1,15 +1,16 @@
 #include "bsp/board_api.h"
+#include "gamepad.h"
+#include "hid_transmit.h"
 #include "tusb.h"
 
 /* A combination of interfaces must have a unique product id, since PC will save device driver after the first plug.
  * Same VID/PID with different interface e.g MSC (first), then CDC (later) will possibly cause system error on PC.
  *
- * Auto ProductID layout's Bitmap:
- *   [MSB]         HID | MSC | CDC          [LSB]
+ * Set explicitly, TinyUSB's auto ProductID bitmap only has room for one HID interface:
+ *   0x4004 keyboard only, as the bitmap gave it
+ *   0x4104 keyboard and gamepad
  */
-#define _PID_MAP(itf, n) ((CFG_TUD_##itf) << (n))
-#define USB_PID \
-    (0x4000 | _PID_MAP(CDC, 0) | _PID_MAP(MSC, 1) | _PID_MAP(HID, 2) | _PID_MAP(MIDI, 3) | _PID_MAP(VENDOR, 4))
+#define USB_PID 0x4104
 
 #define USB_VID 0xCafe
 #define USB_BCD 0x0200
@@ -45,34 +46,61 @@ uint8_t const* tud_descriptor_device_cb(void) {
 // HID Report Descriptor
 //--------------------------------------------------------------------+
 
-uint8_t const desc_hid_report[] = {TUD_HID_REPORT_DESC_KEYBOARD()};
+uint8_t const desc_hid_keyboard_report[] = {TUD_HID_REPORT_DESC_KEYBOARD()};
+
+// Steering is X, centred at rest. Throttle, brake and handbrake are Y, Z and
+// Rz, from released at 0. Matches gamepad_report_t.
+uint8_t const desc_hid_gamepad_report[] = {
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+    HID_USAGE(HID_USAGE_DESKTOP_GAMEPAD),
+    HID_COLLECTION(HID_COLLECTION_APPLICATION),
+    HID_USAGE(HID_USAGE_DESKTOP_X),
+    HID_LOGICAL_MIN_N(-GAMEPAD_AXIS_MAX, 2),
+    HID_LOGICAL_MAX_N(GAMEPAD_AXIS_MAX, 2),
+    HID_REPORT_COUNT(1),
+    HID_REPORT_SIZE(16),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+
+    HID_USAGE(HID_USAGE_DESKTOP_Y),
+    HID_USAGE(HID_USAGE_DESKTOP_Z),
+    HID_USAGE(HID_USAGE_DESKTOP_RZ),
+    HID_LOGICAL_MIN(0),
+    HID_LOGICAL_MAX_N(GAMEPAD_AXIS_MAX, 2),
+    HID_REPORT_COUNT(3),
+    HID_REPORT_SIZE(16),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+    HID_COLLECTION_END,
+};
 
 // Invoked when received GET HID REPORT DESCRIPTOR
 // Application return pointer to descriptor
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const* tud_hid_descriptor_report_cb(uint8_t instance) {
-
-    (void)instance;
-    return desc_hid_report;
+    return HID_INSTANCE_GAMEPAD == instance ? desc_hid_gamepad_report : desc_hid_keyboard_report;
 }
 
 //--------------------------------------------------------------------+
 // Configuration Descriptor
 //--------------------------------------------------------------------+
 
-enum { ITF_NUM_HID, ITF_NUM_TOTAL };
+// Interface numbers match hid_instance_t, TinyUSB numbers HID instances in interface order
+enum { ITF_NUM_KEYBOARD = HID_INSTANCE_KEYBOARD, ITF_NUM_GAMEPAD = HID_INSTANCE_GAMEPAD, ITF_NUM_TOTAL };
 
-#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN)
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + CFG_TUD_HID * TUD_HID_DESC_LEN)
 
-#define EPNUM_HID 0x81
+#define EPNUM_KEYBOARD 0x81
+#define EPNUM_GAMEPAD 0x82
 
 uint8_t const desc_configuration[] = {
     // Config number, interface count, string index, total length, attribute, power in mA
     TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
 
     // Interface number, string index, protocol, report descriptor len, EP In address, size & polling interval
-    TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID,
-                       CFG_TUD_HID_EP_BUFSIZE, 5)};
+    // Both polled every frame, reports go out on the next one
+    TUD_HID_DESCRIPTOR(ITF_NUM_KEYBOARD, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_keyboard_report), EPNUM_KEYBOARD,
+                       CFG_TUD_HID_EP_BUFSIZE, 1),
+    TUD_HID_DESCRIPTOR(ITF_NUM_GAMEPAD, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_gamepad_report), EPNUM_GAMEPAD,
+                       CFG_TUD_HID_EP_BUFSIZE, 1)};
 
 // Invoked when received GET CONFIGURATION DESCRIPTOR
 // Application return pointer to descriptor
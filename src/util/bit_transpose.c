@@ -0,0 +1,14 @@
+#include "util/bit_transpose.h"
+
+void bit_transpose_32x32(uint32_t words[32]) {
+    // Swap ever smaller blocks, first the off diagonal 16x16 blocks, then the
+    // 8x8 blocks within them and so on down to single bits.
+    uint32_t mask = 0x0000FFFF;
+    for (uint32_t block = 16; block != 0; block >>= 1, mask ^= mask << block) {
+        for (uint32_t i = 0; i < 32; i = (i + block + 1) & ~block) {
+            const uint32_t swap = ((words[i] >> block) ^ words[i + block]) & mask;
+            words[i] ^= swap << block;
+            words[i + block] ^= swap;
+        }
+    }
+}
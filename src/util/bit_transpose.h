@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+
+// Transposes a 32x32 bit matrix in place, bit j of word i is swapped with bit i
+// of word j.
+//
+// Used to turn bit planes, one word per clock holding a bit from every data
+// line, into one word per data line. The cost is fixed no matter how many of
+// the bits are in use.
+void bit_transpose_32x32(uint32_t words[32]);
@@ -0,0 +1,146 @@
+#include "util/filter.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "util/tank_assert.h"
+
+#define FILTER_PI 3.14159265358979323846
+#define FILTER_BUTTERWORTH_Q 0.70710678118654752440
+
+static void filter_biquad_init(filter_t* filter, const filter_config_t* config) {
+    TANK_ASSERT_M(0 != config->biquad_sample_rate_hz, "Biquad sample rate must be set");
+    TANK_ASSERT_M(0 != config->biquad_cutoff_mhz, "Biquad cutoff must be set");
+    TANK_ASSERT_M(config->biquad_cutoff_mhz < config->biquad_sample_rate_hz * 500,
+                  "Biquad cutoff must be below half the sample rate");
+
+    // Butterworth low-pass, see the Audio EQ Cookbook
+    const double w0 = 2.0 * FILTER_PI * (config->biquad_cutoff_mhz / 1000.0) / config->biquad_sample_rate_hz;
+    const double alpha = sin(w0) / (2.0 * FILTER_BUTTERWORTH_Q);
+    const double cos_w0 = cos(w0);
+    const double a0 = 1.0 + alpha;
+    const double scale = (double)(1 << FILTER_BIQUAD_COEFFICIENT_BITS) / a0;
+
+    filter->biquad.b0 = (int32_t)lround((1.0 - cos_w0) / 2.0 * scale);
+    filter->biquad.b1 = (int32_t)lround((1.0 - cos_w0) * scale);
+    filter->biquad.b2 = filter->biquad.b0;
+    filter->biquad.a1 = (int32_t)lround(2.0 * cos_w0 * scale);
+    filter->biquad.a2 = (int32_t)lround(-(1.0 - alpha) * scale);
+}
+
+void filter_init(filter_t* filter, const filter_config_t* config) {
+    memset(filter, 0, sizeof(filter_t));
+    filter->type = (filter_type_t)config->type;
+
+    switch (filter->type) {
+        case FILTER_NONE:
+            break;
+        case FILTER_EMA:
+            TANK_ASSERT_M(0 != config->ema_alpha_q16 && config->ema_alpha_q16 <= (1 << 16),
+                          "EMA alpha must be between 1 and 65536");
+            filter->ema.alpha_q16 = config->ema_alpha_q16;
+            break;
+        case FILTER_MEDIAN_3:
+            filter->median.n_samples = 3;
+            break;
+        case FILTER_MEDIAN_5:
+            filter->median.n_samples = 5;
+            break;
+        case FILTER_BIQUAD_LOW_PASS:
+            filter_biquad_init(filter, config);
+            break;
+        default:
+            TANK_ASSERT_M(false, "Unexpected filter_type_t");
+    }
+}
+
+static int32_t filter_ema_apply(filter_t* filter, int32_t sample) {
+    const int64_t sample_q16 = (int64_t)sample << 16;
+    if (!filter->primed) {
+        filter->ema.state_q16 = sample_q16;
+    }
+    filter->ema.state_q16 += ((sample_q16 - filter->ema.state_q16) * filter->ema.alpha_q16) >> 16;
+    return (int32_t)((filter->ema.state_q16 + (1 << 15)) >> 16);
+}
+
+#define FILTER_SORT_2(a, b)  \
+    do {                     \
+        if ((a) > (b)) {     \
+            int32_t t = (a); \
+            (a) = (b);       \
+            (b) = t;         \
+        }                    \
+    } while (0)
+
+static int32_t filter_median_apply(filter_t* filter, int32_t sample) {
+    if (!filter->primed) {
+        for (uint8_t i = 0; i < filter->median.n_samples; i++) {
+            filter->median.history[i] = sample;
+        }
+    }
+    filter->median.history[filter->median.next] = sample;
+    filter->median.next = (filter->median.next + 1) % filter->median.n_samples;
+
+    // Sorting networks, only as many compare and swaps as needed to find the middle
+    int32_t s[FILTER_MEDIAN_MAX_SAMPLES];
+    memcpy(s, filter->median.history, sizeof(s));
+    if (3 == filter->median.n_samples) {
+        FILTER_SORT_2(s[0], s[1]);
+        FILTER_SORT_2(s[1], s[2]);
+        FILTER_SORT_2(s[0], s[1]);
+        return s[1];
+    }
+    FILTER_SORT_2(s[0], s[1]);
+    FILTER_SORT_2(s[3], s[4]);
+    FILTER_SORT_2(s[0], s[3]);
+    FILTER_SORT_2(s[1], s[4]);
+    FILTER_SORT_2(s[1], s[2]);
+    FILTER_SORT_2(s[2], s[3]);
+    FILTER_SORT_2(s[1], s[2]);
+    return s[2];
+}
+
+static int32_t filter_biquad_apply(filter_t* filter, int32_t sample) {
+    if (!filter->primed) {
+        filter->biquad.x1 = filter->biquad.x2 = sample;
+        filter->biquad.y1 = filter->biquad.y2 = sample;
+    }
+
+    // Direct form I with the rounding error of the previous output carried forward
+    int64_t acc = filter->biquad.error;
+    acc += (int64_t)filter->biquad.b0 * sample;
+    acc += (int64_t)filter->biquad.b1 * filter->biquad.x1;
+    acc += (int64_t)filter->biquad.b2 * filter->biquad.x2;
+    acc += (int64_t)filter->biquad.a1 * filter->biquad.y1;
+    acc += (int64_t)filter->biquad.a2 * filter->biquad.y2;
+    const int32_t output = (int32_t)(acc >> FILTER_BIQUAD_COEFFICIENT_BITS);
+    filter->biquad.error = acc - ((int64_t)output << FILTER_BIQUAD_COEFFICIENT_BITS);
+
+    filter->biquad.x2 = filter->biquad.x1;
+    filter->biquad.x1 = sample;
+    filter->biquad.y2 = filter->biquad.y1;
+    filter->biquad.y1 = output;
+    return output;
+}
+
+int32_t filter_apply(filter_t* filter, int32_t sample) {
+    int32_t output = sample;
+    switch (filter->type) {
+        case FILTER_NONE:
+            break;
+        case FILTER_EMA:
+            output = filter_ema_apply(filter, sample);
+            break;
+        case FILTER_MEDIAN_3:
+        case FILTER_MEDIAN_5:
+            output = filter_median_apply(filter, sample);
+            break;
+        case FILTER_BIQUAD_LOW_PASS:
+            output = filter_biquad_apply(filter, sample);
+            break;
+    }
+    filter->primed = true;
+    return output;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Integer only filter stages for a single channel of samples. State lives in
+// the filter_t, which the caller owns, there is no allocation.
+
+typedef enum filter_type {
+    FILTER_NONE,             // Passes samples through untouched
+    FILTER_EMA,              // Exponential moving average
+    FILTER_MEDIAN_3,         // Median of the last 3 samples
+    FILTER_MEDIAN_5,         // Median of the last 5 samples
+    FILTER_BIQUAD_LOW_PASS,  // Second order Butterworth low-pass
+} filter_type_t;
+
+#define FILTER_MEDIAN_MAX_SAMPLES 5
+
+// Biquad coefficients are Q28, which leaves room for |a1| up to 8
+#define FILTER_BIQUAD_COEFFICIENT_BITS 28
+
+typedef struct filter_config {
+    uint8_t type;  // filter_type_t, fixed width so the layout matches on host tools
+
+    // FILTER_EMA: weight given to each new sample in Q16, between 1 and 65536
+    uint32_t ema_alpha_q16;
+
+    // FILTER_BIQUAD_LOW_PASS: cutoff frequency in millihertz and the rate the
+    // filter is applied at in hertz. The cutoff must be below half the sample rate.
+    uint32_t biquad_cutoff_mhz;
+    uint32_t biquad_sample_rate_hz;
+} filter_config_t;
+
+typedef struct filter {
+    filter_type_t type;
+    bool primed;  // Set once the first sample has seeded the state
+    union {
+        struct {
+            int64_t state_q16;
+            uint32_t alpha_q16;
+        } ema;
+        struct {
+            int32_t history[FILTER_MEDIAN_MAX_SAMPLES];
+            uint8_t n_samples;
+            uint8_t next;
+        } median;
+        struct {
+            int32_t b0, b1, b2, a1, a2;  // Q28, a1 and a2 are negated so every term is added
+            int32_t x1, x2, y1, y2;
+            int64_t error;  // Remainder of the last output, fed back so rounding does not bias the output
+        } biquad;
+    };
+} filter_t;
+
+// Sets up `filter` from `config`. Biquad coefficients are designed here, so this
+// is not intended to be called per sample.
+void filter_init(filter_t* filter, const filter_config_t* config);
+
+// Filters one sample, returning the filtered value. The first sample after
+// filter_init() seeds the state, so there is no start up transient.
+int32_t filter_apply(filter_t* filter, int32_t sample);
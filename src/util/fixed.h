@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+// Q16.16 fixed point, the RP2040 has no FPU so the control path stays in
+// integers. 1.0 is exactly representable, which keeps 0..1 quantities exact at
+// their ends.
+
+typedef int32_t q16_t;
+
+#define Q16_FRACTIONAL_BITS 16
+#define Q16_ZERO ((q16_t)0)
+#define Q16_ONE ((q16_t)1 << Q16_FRACTIONAL_BITS)
+
+// Converts a float to Q16, rounding to nearest. Intended for settings at init,
+// not the hot path.
+static inline q16_t q16_from_float(float value) {
+    const float scaled = value * (float)Q16_ONE;
+    return (q16_t)(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+}
+
+static inline float q16_to_float(q16_t value) {
+    return (float)value / (float)Q16_ONE;
+}
+
+// Returns numerator / denominator in Q16, rounded to nearest. Both are in the
+// same units, which need not be Q16. The denominator must be positive.
+static inline q16_t q16_ratio(int64_t numerator, int64_t denominator) {
+    const int64_t scaled = numerator * Q16_ONE;
+    const int64_t half = denominator / 2;
+    return (q16_t)(scaled >= 0 ? (scaled + half) / denominator : (scaled - half) / denominator);
+}
+
+static inline q16_t q16_clamp(q16_t value, q16_t min, q16_t max) {
+    return value < min ? min : (value > max ? max : value);
+}
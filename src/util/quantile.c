@@ -0,0 +1,122 @@
+#include "util/quantile.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "util/tank_assert.h"
+
+#define QUANTILE_ONE_Q16 ((int64_t)1 << 16)
+
+static void quantile_sort(int32_t* values, uint32_t n) {
+    for (uint32_t i = 1; i < n; i++) {
+        const int32_t value = values[i];
+        uint32_t j = i;
+        for (; j > 0 && values[j - 1] > value; j--) {
+            values[j] = values[j - 1];
+        }
+        values[j] = value;
+    }
+}
+
+void quantile_init(quantile_t* quantile, uint32_t p_q16) {
+    TANK_ASSERT_M(p_q16 <= QUANTILE_ONE_Q16, "Quantile must be between 0 and 1");
+    memset(quantile, 0, sizeof(quantile_t));
+    quantile->p_q16 = p_q16;
+
+    const int64_t p = p_q16;
+    quantile->increment_q16[0] = 0;
+    quantile->increment_q16[1] = p / 2;
+    quantile->increment_q16[2] = p;
+    quantile->increment_q16[3] = (QUANTILE_ONE_Q16 + p) / 2;
+    quantile->increment_q16[4] = QUANTILE_ONE_Q16;
+}
+
+// Piecewise parabolic prediction of marker `i` moved by `d`, one of -1 or 1
+static int32_t quantile_parabolic(const quantile_t* quantile, uint8_t i, int32_t d) {
+    const int32_t* q = quantile->heights;
+    const int32_t* n = quantile->positions;
+    const int64_t below = (int64_t)(n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]);
+    const int64_t above = (int64_t)(n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]);
+    return (int32_t)(q[i] + d * (below + above) / (n[i + 1] - n[i - 1]));
+}
+
+// Linear prediction of marker `i` moved by `d`, used when the parabola would
+// leave the markers out of order
+static int32_t quantile_linear(const quantile_t* quantile, uint8_t i, int32_t d) {
+    const int32_t* q = quantile->heights;
+    const int32_t* n = quantile->positions;
+    return (int32_t)(q[i] + (int64_t)d * (q[i + d] - q[i]) / (n[i + d] - n[i]));
+}
+
+void quantile_add(quantile_t* quantile, int32_t sample) {
+    int32_t* q = quantile->heights;
+    int32_t* n = quantile->positions;
+
+    // Collect the first samples as the initial markers
+    if (quantile->count < QUANTILE_MARKERS) {
+        q[quantile->count++] = sample;
+        if (QUANTILE_MARKERS == quantile->count) {
+            quantile_sort(q, QUANTILE_MARKERS);
+            for (uint8_t i = 0; i < QUANTILE_MARKERS; i++) {
+                n[i] = i + 1;
+                quantile->desired_q16[i] = QUANTILE_ONE_Q16 + 4 * quantile->increment_q16[i];
+            }
+        }
+        return;
+    }
+    quantile->count++;
+
+    // Find the cell the sample falls in, stretching the extremes if needed
+    uint8_t k = 0;
+    if (sample < q[0]) {
+        q[0] = sample;
+        k = 0;
+    } else if (sample >= q[QUANTILE_MARKERS - 1]) {
+        q[QUANTILE_MARKERS - 1] = sample;
+        k = QUANTILE_MARKERS - 2;
+    } else {
+        while (sample >= q[k + 1]) {
+            k++;
+        }
+    }
+
+    for (uint8_t i = k + 1; i < QUANTILE_MARKERS; i++) {
+        n[i]++;
+    }
+    for (uint8_t i = 0; i < QUANTILE_MARKERS; i++) {
+        quantile->desired_q16[i] += quantile->increment_q16[i];
+    }
+
+    // Move the middle markers towards their desired positions
+    for (uint8_t i = 1; i < QUANTILE_MARKERS - 1; i++) {
+        const int64_t error_q16 = quantile->desired_q16[i] - ((int64_t)n[i] << 16);
+        const int32_t d = error_q16 >= QUANTILE_ONE_Q16 ? 1 : (error_q16 <= -QUANTILE_ONE_Q16 ? -1 : 0);
+        if (0 == d || n[i + d] - n[i] == d) {
+            continue;
+        }
+
+        int32_t height = quantile_parabolic(quantile, i, d);
+        if (height <= q[i - 1] || height >= q[i + 1]) {
+            height = quantile_linear(quantile, i, d);
+        }
+        q[i] = height;
+        n[i] += d;
+    }
+}
+
+int32_t quantile_get(const quantile_t* quantile) {
+    if (0 == quantile->count) {
+        return 0;
+    }
+
+    // Exact, from the few samples there are
+    if (quantile->count < QUANTILE_MARKERS) {
+        int32_t sorted[QUANTILE_MARKERS];
+        memcpy(sorted, quantile->heights, sizeof(sorted));
+        quantile_sort(sorted, quantile->count);
+        const uint32_t rank = (uint32_t)(((int64_t)quantile->p_q16 * (quantile->count - 1) + (1 << 15)) >> 16);
+        return sorted[rank];
+    }
+
+    return quantile->heights[2];
+}
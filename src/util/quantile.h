@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+// Streaming quantile estimate using the P² algorithm (Jain & Chlamtac, 1985).
+// Constant memory and O(1) per sample, all integer maths.
+
+#define QUANTILE_MARKERS 5
+
+typedef struct quantile {
+    uint32_t p_q16;  // Quantile being estimated, Q16
+    uint32_t count;  // Samples seen so far
+    int32_t heights[QUANTILE_MARKERS];
+    int32_t positions[QUANTILE_MARKERS];      // Actual marker positions, 1 based
+    int64_t desired_q16[QUANTILE_MARKERS];    // Desired marker positions, Q16
+    int64_t increment_q16[QUANTILE_MARKERS];  // Desired position increment per sample, Q16
+} quantile_t;
+
+// Starts a new estimate of the `p_q16` quantile, between 0 and 65536.
+void quantile_init(quantile_t* quantile, uint32_t p_q16);
+
+// Adds a sample to the estimate.
+void quantile_add(quantile_t* quantile, int32_t sample);
+
+// Returns the current estimate, or 0 if no samples have been added. Until
+// there are enough samples for the markers this is the exact quantile.
+int32_t quantile_get(const quantile_t* quantile);
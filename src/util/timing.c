@@ -0,0 +1,21 @@
+#include "util/timing.h"
+
+#include <hardware/clocks.h>
+
+#include "util/tank_assert.h"
+
+static uint32_t timing_clk_sys_hz = 0;
+
+void timing_init(void) {
+    timing_clk_sys_hz = clock_get_hz(clk_sys);
+}
+
+uint32_t timing_sys_clk_hz(void) {
+    TANK_ASSERT_M(0 != timing_clk_sys_hz, "timing_init() has not been called");
+    return timing_clk_sys_hz;
+}
+
+uint32_t timing_ns_to_cycles(uint32_t ns) {
+    const uint64_t ns_per_s = 1000000000;
+    return (uint32_t)(((uint64_t)ns * timing_sys_clk_hz() + ns_per_s - 1) / ns_per_s);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <pico/platform.h>
+#include <stdint.h>
+
+// Busy wait timing derived from the system clock, for bit-banged protocols
+// that need delays shorter than sleep_us() can provide.
+
+// Caches the clk_sys frequency. Must be called before any other timing function
+// and again whenever clk_sys is changed.
+void timing_init(void);
+
+// Returns the clk_sys frequency cached by timing_init().
+uint32_t timing_sys_clk_hz(void);
+
+// Returns the number of clk_sys cycles needed to wait at least `ns` nanoseconds.
+// Intended to be called once at init, the result passed to timing_delay_cycles().
+uint32_t timing_ns_to_cycles(uint32_t ns);
+
+// Waits for at least `cycles` clk_sys cycles.
+__attribute__((always_inline)) static inline void timing_delay_cycles(uint32_t cycles) {
+    busy_wait_at_least_cycles(cycles);
+}
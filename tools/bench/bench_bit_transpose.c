@@ -0,0 +1,102 @@
+// Compares extracting HX710C conversions from sampled SDA pins one pin at a
+// time, as the driver used to, against sampling every pin at once and
+// transposing the bit planes.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "util/bit_transpose.h"
+
+#define BENCH_ITERATIONS 200000
+#define BENCH_BITS_PER_CONVERSION 24
+
+static uint64_t bench_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+// Stands in for gpio_get(), reading a single pin out of a sampled bit plane
+static inline uint32_t bench_pin_get(const volatile uint32_t* plane, uint8_t pin) {
+    return (*plane >> pin) & 0x1;
+}
+
+// One pin per device per bit
+static void bench_extract_per_pin(const volatile uint32_t* planes, const uint8_t* pins, uint8_t n_pins,
+                                  uint32_t* conversions) {
+    memset(conversions, 0, n_pins * sizeof(uint32_t));
+    for (int8_t bit = BENCH_BITS_PER_CONVERSION - 1; bit > -1; bit--) {
+        for (uint8_t i = 0; i < n_pins; i++) {
+            conversions[i] |= bench_pin_get(&planes[bit], pins[i]) << bit;
+        }
+    }
+}
+
+// One read per bit, then transpose
+static void bench_extract_transpose(const volatile uint32_t* planes, const uint8_t* pins, uint8_t n_pins,
+                                    uint32_t* conversions) {
+    uint32_t bit_planes[32] = {0};
+    for (int8_t bit = BENCH_BITS_PER_CONVERSION - 1; bit > -1; bit--) {
+        bit_planes[bit] = planes[bit];
+    }
+    bit_transpose_32x32(bit_planes);
+    for (uint8_t i = 0; i < n_pins; i++) {
+        conversions[i] = bit_planes[pins[i]];
+    }
+}
+
+int main(void) {
+    const uint8_t channel_counts[] = {1, 2, 4, 8, 16, 24};
+    srand(1);
+
+    printf("channels,per_pin_ns,transpose_ns\n");
+    for (size_t c = 0; c < sizeof(channel_counts) / sizeof(channel_counts[0]); c++) {
+        const uint8_t n_pins = channel_counts[c];
+
+        // Spread the SDA pins across the bank like a real board would
+        uint8_t pins[32];
+        for (uint8_t i = 0; i < n_pins; i++) {
+            pins[i] = (uint8_t)(i + 2);
+        }
+
+        // Sample some random conversions onto the pins
+        uint32_t expected[32];
+        volatile uint32_t planes[BENCH_BITS_PER_CONVERSION] = {0};
+        for (uint8_t i = 0; i < n_pins; i++) {
+            expected[i] = (uint32_t)rand() & 0x00FFFFFF;
+            for (uint8_t bit = 0; bit < BENCH_BITS_PER_CONVERSION; bit++) {
+                planes[bit] |= ((expected[i] >> bit) & 0x1) << pins[i];
+            }
+        }
+
+        // Both methods must agree before their timings mean anything
+        uint32_t per_pin[32];
+        uint32_t transposed[32];
+        bench_extract_per_pin(planes, pins, n_pins, per_pin);
+        bench_extract_transpose(planes, pins, n_pins, transposed);
+        if (0 != memcmp(per_pin, expected, n_pins * sizeof(uint32_t)) ||
+            0 != memcmp(transposed, expected, n_pins * sizeof(uint32_t))) {
+            fprintf(stderr, "Extracted conversions do not match for %u channels\n", n_pins);
+            return EXIT_FAILURE;
+        }
+
+        uint64_t start = bench_now_ns();
+        for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+            bench_extract_per_pin(planes, pins, n_pins, per_pin);
+        }
+        const double per_pin_ns = (double)(bench_now_ns() - start) / BENCH_ITERATIONS;
+
+        start = bench_now_ns();
+        for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+            bench_extract_transpose(planes, pins, n_pins, transposed);
+        }
+        const double transpose_ns = (double)(bench_now_ns() - start) / BENCH_ITERATIONS;
+
+        printf("%u,%.1f,%.1f\n", n_pins, per_pin_ns, transpose_ns);
+    }
+
+    return EXIT_SUCCESS;
+}
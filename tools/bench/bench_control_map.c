@@ -0,0 +1,257 @@
+// Checks the Q16 control path, raw sensor values to duty cycles, against a
+// rational reference model. Each stage, raw to report and report to output,
+// must be within one LSB of the model. Also reports how far the whole path
+// strays from the float implementation it replaced, and times both.
+//
+// Host timings use a hardware FPU, so they understate the saving on the
+// RP2040 where every float operation is a library call. The helper_calls
+// target of the firmware build counts those calls for both paths.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bench_float_control_map.h"
+#include "control/control_map.h"
+#include "util/helpers.h"
+
+#define BENCH_REPORTS 100000
+#define BENCH_ITERATIONS 20
+
+static uint64_t bench_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static int32_t bench_random(int32_t min, int32_t max) {
+    const uint64_t r = ((uint64_t)rand() << 31) ^ (uint64_t)rand();
+    return (int32_t)(min + (int64_t)(r % (uint64_t)((int64_t)max - min + 1)));
+}
+
+// =============================================================================
+// Reference model, exact ratios rounded half away from zero like q16_ratio()
+// =============================================================================
+
+static q16_t model_ratio(int64_t numerator, int64_t denominator) {
+    return (q16_t)round((double)numerator * Q16_ONE / (double)denominator);
+}
+
+static q16_t model_scale(int32_t current, int32_t min, int32_t max) {
+    if (max == min) {
+        return 0;
+    }
+    const q16_t value = model_ratio((int64_t)current - min, (int64_t)max - min);
+    return value < 0 ? 0 : (value > Q16_ONE ? Q16_ONE : value);
+}
+
+static q16_t model_span(q16_t value, q16_t begin, q16_t end) {
+    if (end <= begin) {
+        return Q16_ONE;
+    }
+    return MIN_OF(model_ratio(value - begin, end - begin), Q16_ONE);
+}
+
+static input_report_t model_report(const control_raw_report_t* raw,
+                                   const control_raw_report_t* min,
+                                   const control_raw_report_t* max) {
+    input_report_t report = {
+        .accelerator = Q16_ONE - model_scale(raw->accelerator, min->accelerator, max->accelerator),
+        .left_tiller = model_scale(raw->left_tiller, min->left_tiller, max->left_tiller),
+        .right_tiller = model_scale(raw->right_tiller, min->right_tiller, max->right_tiller),
+    };
+    return report;
+}
+
+static keyboard_output_t model_map(const control_settings_t* settings, const input_report_t* report) {
+    const q16_t pedal_deadzone = q16_from_float(settings->pedal_deadzone);
+    const q16_t tiller_deadzone = q16_from_float(settings->tiller_deadzone);
+    const q16_t max_turn = q16_from_float(settings->tiller_max_turn_threshold);
+    const q16_t handbrake_begin = q16_from_float(settings->tiller_handbrake_threshold_begin);
+    const q16_t handbrake_end = q16_from_float(settings->tiller_handbrake_threshold_end);
+    const q16_t tillers[2] = {report->left_tiller, report->right_tiller};
+
+    keyboard_output_t output = {0};
+    if (report->accelerator >= pedal_deadzone) {
+        output.forward_duty_cycle = model_span(report->accelerator, pedal_deadzone, Q16_ONE);
+    }
+    q16_t side[2] = {0};
+    for (int i = 0; i < 2; i++) {
+        if (tillers[i] < tiller_deadzone) {
+            continue;
+        }
+        side[i] = model_span(tillers[i], tiller_deadzone, max_turn);
+        if (tillers[i] > handbrake_begin) {
+            output.hand_brake_duty_cycle =
+                MAX_OF(output.hand_brake_duty_cycle, model_span(tillers[i], handbrake_begin, handbrake_end));
+        }
+    }
+    output.left_duty_cycle = side[0];
+    output.right_duty_cycle = side[1];
+    return output;
+}
+
+// =============================================================================
+
+typedef struct bench_sample {
+    control_raw_report_t raw;
+    control_raw_report_t min;
+    control_raw_report_t max;
+} bench_sample_t;
+
+static void bench_make_sample(bench_sample_t* sample) {
+    const int32_t pedal_max = INPUT_RAW_PEDAL_ABSOLUTE_MAX;
+    const int32_t tiller_min = INPUT_RAW_TILLER_ABSOLUTE_MIN;
+    const int32_t tiller_max = INPUT_RAW_TILLER_ABSOLUTE_MAX;
+
+    sample->min.accelerator = (int16_t)bench_random(0, pedal_max / 4);
+    sample->max.accelerator = (int16_t)bench_random(pedal_max / 2, pedal_max);
+    sample->raw.accelerator = (int16_t)bench_random(0, pedal_max);
+    sample->min.left_tiller = bench_random(tiller_min, 0);
+    sample->max.left_tiller = bench_random(1, tiller_max);
+    sample->raw.left_tiller = bench_random(tiller_min, tiller_max);
+    sample->min.right_tiller = bench_random(tiller_min, 0);
+    sample->max.right_tiller = bench_random(1, tiller_max);
+    sample->raw.right_tiller = bench_random(tiller_min, tiller_max);
+}
+
+static int32_t bench_abs_difference(q16_t fixed, float reference) {
+    return abs(fixed - q16_from_float(reference));
+}
+
+static int32_t bench_report_difference(const input_report_t* a, const input_report_t* b) {
+    int32_t worst = abs(a->accelerator - b->accelerator);
+    worst = MAX_OF(worst, abs(a->left_tiller - b->left_tiller));
+    return MAX_OF(worst, abs(a->right_tiller - b->right_tiller));
+}
+
+static int32_t bench_output_difference(const keyboard_output_t* a, const keyboard_output_t* b) {
+    int32_t worst = abs(a->forward_duty_cycle - b->forward_duty_cycle);
+    worst = MAX_OF(worst, abs(a->left_duty_cycle - b->left_duty_cycle));
+    worst = MAX_OF(worst, abs(a->right_duty_cycle - b->right_duty_cycle));
+    return MAX_OF(worst, abs(a->hand_brake_duty_cycle - b->hand_brake_duty_cycle));
+}
+
+int main(void) {
+    static bench_sample_t samples[BENCH_REPORTS];
+    static control_transform_t transforms[BENCH_REPORTS];
+    const control_settings_t settings = {.pedal_deadzone = 0.07,
+                                         .tiller_deadzone = 0.07,
+                                         .tiller_handbrake_threshold_begin = 0.8,
+                                         .tiller_handbrake_threshold_end = 0.9,
+                                         .tiller_max_turn_threshold = 0.65};
+    const control_raw_timestamps_t timestamps = {0};
+
+    // Every sample has its own calibration, so each gets its own transform
+    srand(1);
+    for (size_t i = 0; i < BENCH_REPORTS; i++) {
+        bench_make_sample(&samples[i]);
+        control_transform_build(&transforms[i], &settings, &samples[i].min, &samples[i].max);
+    }
+
+    // Each stage against the model, and the largest difference from float
+    int32_t worst_report_lsb = 0;
+    int32_t worst_output_lsb = 0;
+    int32_t worst_float_lsb = 0;
+    for (size_t i = 0; i < BENCH_REPORTS; i++) {
+        const bench_sample_t* s = &samples[i];
+        const input_report_t report = input_make_report(&transforms[i], &s->raw, &timestamps);
+        const input_report_t expected_report = model_report(&s->raw, &s->min, &s->max);
+        worst_report_lsb = MAX_OF(worst_report_lsb, bench_report_difference(&report, &expected_report));
+
+        const keyboard_output_t fixed = map_input_to_output(&transforms[i], &report);
+        const keyboard_output_t expected_output = model_map(&settings, &report);
+        worst_output_lsb = MAX_OF(worst_output_lsb, bench_output_difference(&fixed, &expected_output));
+
+        const float_output_t reference = float_map(&settings, &s->raw, &s->min, &s->max);
+        worst_float_lsb = MAX_OF(worst_float_lsb, bench_abs_difference(fixed.forward_duty_cycle, reference.forward));
+        worst_float_lsb = MAX_OF(worst_float_lsb, bench_abs_difference(fixed.left_duty_cycle, reference.left));
+        worst_float_lsb = MAX_OF(worst_float_lsb, bench_abs_difference(fixed.right_duty_cycle, reference.right));
+        worst_float_lsb =
+            MAX_OF(worst_float_lsb, bench_abs_difference(fixed.hand_brake_duty_cycle, reference.hand_brake));
+    }
+
+    // Time both paths, with one calibration as the firmware would have
+    volatile q16_t fixed_sink = 0;
+    uint64_t start = bench_now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (size_t i = 0; i < BENCH_REPORTS; i++) {
+            const bench_sample_t* s = &samples[i];
+            const input_report_t report = input_make_report(&transforms[0], &s->raw, &timestamps);
+            fixed_sink = map_input_to_output(&transforms[0], &report).forward_duty_cycle;
+        }
+    }
+    const double fixed_ns = (double)(bench_now_ns() - start) / ((double)BENCH_ITERATIONS * BENCH_REPORTS);
+
+    // Batched, from structure of arrays buffers
+    static int16_t raw_accelerator[BENCH_REPORTS];
+    static int32_t raw_left_tiller[BENCH_REPORTS];
+    static int32_t raw_right_tiller[BENCH_REPORTS];
+    static q16_t report_arrays[3][BENCH_REPORTS];
+    static q16_t output_arrays[5][BENCH_REPORTS];
+    for (size_t i = 0; i < BENCH_REPORTS; i++) {
+        raw_accelerator[i] = samples[i].raw.accelerator;
+        raw_left_tiller[i] = samples[i].raw.left_tiller;
+        raw_right_tiller[i] = samples[i].raw.right_tiller;
+    }
+    const control_raw_batch_t raw_batch = {
+        .accelerator = raw_accelerator, .left_tiller = raw_left_tiller, .right_tiller = raw_right_tiller};
+    const input_report_batch_t report_batch = {
+        .accelerator = report_arrays[0], .left_tiller = report_arrays[1], .right_tiller = report_arrays[2]};
+    const keyboard_output_batch_t output_batch = {.forward_duty_cycle = output_arrays[0],
+                                                  .left_duty_cycle = output_arrays[1],
+                                                  .right_duty_cycle = output_arrays[2],
+                                                  .reverse_duty_cycle = output_arrays[3],
+                                                  .hand_brake_duty_cycle = output_arrays[4]};
+    start = bench_now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        input_make_report_batch(&transforms[0], &raw_batch, BENCH_REPORTS, &report_batch);
+        map_input_to_output_batch(&transforms[0], &report_batch, BENCH_REPORTS, &output_batch);
+    }
+    const double batch_ns = (double)(bench_now_ns() - start) / ((double)BENCH_ITERATIONS * BENCH_REPORTS);
+
+    // The batch must agree with the single sample path
+    uint32_t batch_mismatches = 0;
+    for (size_t i = 0; i < BENCH_REPORTS; i++) {
+        const input_report_t report = input_make_report(&transforms[0], &samples[i].raw, &timestamps);
+        const keyboard_output_t output = map_input_to_output(&transforms[0], &report);
+        const keyboard_output_t batch_output = {.forward_duty_cycle = output_arrays[0][i],
+                                                .left_duty_cycle = output_arrays[1][i],
+                                                .right_duty_cycle = output_arrays[2][i],
+                                                .reverse_duty_cycle = output_arrays[3][i],
+                                                .hand_brake_duty_cycle = output_arrays[4][i]};
+        if (0 != bench_output_difference(&output, &batch_output) ||
+            output.reverse_duty_cycle != batch_output.reverse_duty_cycle) {
+            batch_mismatches++;
+        }
+    }
+
+    volatile float float_sink = 0;
+    start = bench_now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (size_t i = 0; i < BENCH_REPORTS; i++) {
+            const bench_sample_t* s = &samples[i];
+            float_sink = float_map(&settings, &s->raw, &samples[0].min, &samples[0].max).forward;
+        }
+    }
+    const double float_ns = (double)(bench_now_ns() - start) / ((double)BENCH_ITERATIONS * BENCH_REPORTS);
+    (void)fixed_sink;
+    (void)float_sink;
+
+    printf("reports,worst_report_lsb,worst_output_lsb,worst_float_difference_lsb,batch_mismatches,float_ns,fixed_ns,"
+           "batch_ns\n");
+    printf("%d,%d,%d,%d,%u,%.1f,%.1f,%.1f\n", BENCH_REPORTS, worst_report_lsb, worst_output_lsb, worst_float_lsb,
+           batch_mismatches, float_ns, fixed_ns, batch_ns);
+
+    // The report is rounded to Q16 before mapping, and mapping divides by spans
+    // as small as the 0.1 wide handbrake band, so a rounding error can grow
+    // tenfold end to end. Allow 1/4096 of full scale, far below one PWM tick.
+    if (worst_report_lsb > 1 || worst_output_lsb > 1 || worst_float_lsb > 16 || 0 != batch_mismatches) {
+        fprintf(stderr, "Fixed point control path does not match the reference\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+// Times each stage of the control path on the host, with the float control
+// path the Q16 one replaced alongside as the baseline. Host timings run on a
+// hardware FPU, so the cost of each path on the RP2040 is counted separately
+// in the firmware build, see the helper_calls target in src/CMakeLists.txt.
+// Results are CSV on stdout.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+#include "bench_float_control_map.h"
+#include "control/control_map.h"
+#include "control/control_pipeline.h"
+#include "usb_keyboard/key_modulator.h"
+#include "util/filter.h"
+}
+
+namespace {
+
+constexpr size_t bench_samples = 4096;
+constexpr uint32_t bench_iterations = 200;
+constexpr uint32_t bench_init_iterations = 2;
+
+control_settings_t bench_settings() {
+    control_settings_t settings = {};
+    settings.pedal_deadzone = 0.07f;
+    settings.tiller_deadzone = 0.07f;
+    settings.tiller_handbrake_threshold_begin = 0.8f;
+    settings.tiller_handbrake_threshold_end = 0.9f;
+    settings.tiller_max_turn_threshold = 0.65f;
+    settings.pedal_response_curve.type = RESPONSE_CURVE_EXPO;
+    settings.pedal_response_curve.strength = 0.5f;
+    settings.tiller_response_curve.type = RESPONSE_CURVE_S_CURVE;
+    settings.tiller_response_curve.strength = 0.3f;
+    return settings;
+}
+
+// Deterministic raw sample `i`
+control_raw_report_t bench_sample(size_t i) {
+    uint32_t state = static_cast<uint32_t>(i) * 2654435761u + 12345u;
+    const auto next = [&state] {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+    control_raw_report_t raw = {};
+    raw.accelerator = static_cast<int16_t>(next() % 16384u);
+    raw.left_tiller = static_cast<int32_t>(next() % 3200000u) - 100000;
+    raw.right_tiller = static_cast<int32_t>(next() % 3200000u) - 100000;
+    return raw;
+}
+
+template <typename Function>
+double bench_ns_per_op(uint32_t iterations, Function&& function) {
+    volatile int32_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < iterations; n++) {
+        for (size_t i = 0; i < bench_samples; i++) {
+            sink = function(i);
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (double(iterations) * bench_samples);
+}
+
+}  // namespace
+
+int main() {
+    const control_settings_t settings = bench_settings();
+    control_raw_report_t min = {};
+    control_raw_report_t max = {};
+    min.accelerator = 800;
+    max.accelerator = 15000;
+    min.left_tiller = min.right_tiller = -20000;
+    max.left_tiller = max.right_tiller = 3000000;
+    control_transform_t transform;
+    control_transform_build(&transform, &settings, &min, &max);
+
+    filter_config_t filter_config = {};
+    filter_config.type = FILTER_BIQUAD_LOW_PASS;
+    filter_config.biquad_cutoff_mhz = 8000;
+    filter_config.biquad_sample_rate_hz = 40;
+    filter_t filter;
+    filter_init(&filter, &filter_config);
+
+    std::vector<control_raw_report_t> raw(bench_samples);
+    std::vector<input_report_t> reports(bench_samples);
+    const control_raw_timestamps_t timestamps = {};
+    for (size_t i = 0; i < bench_samples; i++) {
+        raw[i] = bench_sample(i);
+        reports[i] = input_make_report(&transform, &raw[i], &timestamps);
+    }
+
+    const key_modulator_config_t modulator_config = {
+        .min_press_us = 20000, .min_release_us = 20000, .consumer_tick_us = 0};
+    key_modulator_t modulator;
+    key_modulator_init(&modulator);
+    uint32_t now_us = 0;
+
+    // Init paths run on config changes, the rest per sample or report
+    printf("path,ns_per_op\n");
+    printf("control_transform_build,%.1f\n", bench_ns_per_op(bench_init_iterations, [&](size_t) {
+               control_transform_build(&transform, &settings, &min, &max);
+               return transform.pedal.scale;
+           }));
+    printf("filter_init,%.1f\n", bench_ns_per_op(bench_init_iterations, [&](size_t) {
+               filter_init(&filter, &filter_config);
+               return filter.biquad.b0;
+           }));
+    printf("filter_apply,%.1f\n", bench_ns_per_op(bench_iterations, [&](size_t i) {
+               return filter_apply(&filter, raw[i].left_tiller);
+           }));
+    printf("input_make_report,%.1f\n", bench_ns_per_op(bench_iterations, [&](size_t i) {
+               return input_make_report(&transform, &raw[i], &timestamps).accelerator;
+           }));
+    printf("map_input_to_output,%.1f\n", bench_ns_per_op(bench_iterations, [&](size_t i) {
+               return map_input_to_output(&transform, &reports[i]).forward_duty_cycle;
+           }));
+    printf("control_pipeline_run,%.1f\n", bench_ns_per_op(bench_iterations, [&](size_t i) {
+               return control_pipeline_run(&transform, &raw[i]).forward_duty_cycle;
+           }));
+    printf("key_modulator_update,%.1f\n", bench_ns_per_op(bench_iterations, [&](size_t i) {
+               now_us += 10000;
+               return int32_t(key_modulator_update(&modulator, &modulator_config, raw[i].accelerator * 4, now_us));
+           }));
+    printf("float_control_map,%.1f\n", bench_ns_per_op(bench_iterations, [&](size_t i) {
+               return int32_t(float_map(&settings, &raw[i], &min, &max).forward * 65536);
+           }));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+// Compares the compile time pipeline in control/control_pipeline.hpp against
+// input_make_report() followed by map_input_to_output(). The outputs must be
+// identical before the timings mean anything.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "control/control_pipeline.h"
+#include "control/control_pipeline.hpp"
+
+namespace {
+
+constexpr size_t bench_reports = 100000;
+constexpr uint32_t bench_iterations = 50;
+
+template <typename Function>
+double bench_ns_per_report(const std::vector<control_raw_report_t>& raw, Function&& function) {
+    volatile q16_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < bench_iterations; n++) {
+        for (const auto& report : raw) {
+            sink = function(report).forward_duty_cycle;
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (double(bench_iterations) * raw.size());
+}
+
+bool bench_equal(const keyboard_output_t& a, const keyboard_output_t& b) {
+    return a.forward_duty_cycle == b.forward_duty_cycle && a.left_duty_cycle == b.left_duty_cycle &&
+           a.right_duty_cycle == b.right_duty_cycle && a.reverse_duty_cycle == b.reverse_duty_cycle &&
+           a.hand_brake_duty_cycle == b.hand_brake_duty_cycle;
+}
+
+// Checks the pipeline against the C functions for every report under `settings`
+bool bench_matches(const control_settings_t& settings, const control_raw_report_t& min, const control_raw_report_t& max,
+                   const std::vector<control_raw_report_t>& raw) {
+    control_transform_t transform;
+    control_transform_build(&transform, &settings, &min, &max);
+    const control_raw_timestamps_t timestamps = {};
+    for (const auto& report : raw) {
+        const input_report_t input = input_make_report(&transform, &report, &timestamps);
+        if (!bench_equal(map_input_to_output(&transform, &input), control_pipeline_run(&transform, &report))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    control_settings_t settings = {};
+    settings.pedal_deadzone = 0.07f;
+    settings.tiller_deadzone = 0.07f;
+    settings.tiller_handbrake_threshold_begin = 0.8f;
+    settings.tiller_handbrake_threshold_end = 0.9f;
+    settings.tiller_max_turn_threshold = 0.65f;
+    settings.pedal_response_curve.type = RESPONSE_CURVE_EXPO;
+    settings.pedal_response_curve.strength = 0.5f;
+    settings.tiller_response_curve.type = RESPONSE_CURVE_S_CURVE;
+    settings.tiller_response_curve.strength = 0.3f;
+
+    control_raw_report_t min = {};
+    control_raw_report_t max = {};
+    min.accelerator = 800;
+    max.accelerator = 15000;
+    min.left_tiller = min.right_tiller = -20000;
+    max.left_tiller = max.right_tiller = 3000000;
+
+    control_transform_t transform;
+    control_transform_build(&transform, &settings, &min, &max);
+    const control_raw_timestamps_t timestamps = {};
+
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int32_t> pedal(INPUT_RAW_PEDAL_ABSOLUTE_MIN, INPUT_RAW_PEDAL_ABSOLUTE_MAX);
+    std::uniform_int_distribution<int32_t> tiller(-100000, 3100000);
+    std::vector<control_raw_report_t> raw(bench_reports);
+    for (auto& report : raw) {
+        report.accelerator = int16_t(pedal(random));
+        report.left_tiller = tiller(random);
+        report.right_tiller = tiller(random);
+    }
+    raw.front().accelerator = min.accelerator;  // Pedal at rest
+
+    const auto functions = [&](const control_raw_report_t& report) {
+        const input_report_t input = input_make_report(&transform, &report, &timestamps);
+        return map_input_to_output(&transform, &input);
+    };
+    const auto pipeline = [&](const control_raw_report_t& report) { return control_pipeline_run(&transform, &report); };
+
+    // The defaults, then curves that are off zero at zero input, which the deadzones must still hold at zero
+    control_settings_t lifted = settings;
+    lifted.pedal_response_curve = {};
+    lifted.pedal_response_curve.type = RESPONSE_CURVE_PIECEWISE;
+    lifted.pedal_response_curve.n_points = 2;
+    lifted.pedal_response_curve.points_x[1] = 1.0f;
+    lifted.pedal_response_curve.points_y[0] = 0.2f;
+    lifted.pedal_response_curve.points_y[1] = 1.0f;
+    lifted.tiller_response_curve = lifted.pedal_response_curve;
+    if (!bench_matches(settings, min, max, raw) || !bench_matches(lifted, min, max, raw)) {
+        std::fprintf(stderr, "Pipeline output differs from the C functions\n");
+        return EXIT_FAILURE;
+    }
+
+    const double functions_ns = bench_ns_per_report(raw, functions);
+    const double pipeline_ns = bench_ns_per_report(raw, pipeline);
+    std::printf("reports,functions_ns,pipeline_ns\n");
+    std::printf("%zu,%.1f,%.1f\n", bench_reports, functions_ns, pipeline_ns);
+    return EXIT_SUCCESS;
+}
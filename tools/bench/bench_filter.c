@@ -0,0 +1,176 @@
+// Checks each util/filter.h stage against a double precision reference, then
+// times them. Reports nanoseconds per sample and, where the host has a cycle
+// counter, cycles per sample.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLE_COUNTER 1
+#else
+#define BENCH_HAS_CYCLE_COUNTER 0
+#endif
+
+#include "util/filter.h"
+
+#define BENCH_SAMPLES 4096
+#define BENCH_ITERATIONS 500
+
+static uint64_t bench_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static uint64_t bench_now_cycles(void) {
+#if BENCH_HAS_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Tiller like input, a slow sine plus noise and the odd spike
+static void bench_make_input(int32_t* samples, size_t n) {
+    srand(1);
+    for (size_t i = 0; i < n; i++) {
+        const double signal = 2000000.0 * sin(2.0 * M_PI * (double)i / 400.0);
+        const double noise = (double)(rand() % 20001 - 10000);
+        const double spike = (0 == rand() % 97) ? 500000.0 : 0.0;
+        samples[i] = (int32_t)(signal + noise + spike);
+    }
+}
+
+static int bench_compare_int32(const void* a, const void* b) {
+    const int32_t x = *(const int32_t*)a;
+    const int32_t y = *(const int32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Reference implementations, returns the largest difference from the filter
+static double bench_check_ema(const int32_t* input, size_t n, uint32_t alpha_q16) {
+    filter_t filter;
+    filter_init(&filter, &(filter_config_t){.type = FILTER_EMA, .ema_alpha_q16 = alpha_q16});
+    const double alpha = alpha_q16 / 65536.0;
+    double state = input[0];
+    double worst = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        state += (input[i] - state) * alpha;
+        worst = fmax(worst, fabs(state - filter_apply(&filter, input[i])));
+    }
+    return worst;
+}
+
+static double bench_check_median(const int32_t* input, size_t n, filter_type_t type, size_t window) {
+    filter_t filter;
+    filter_init(&filter, &(filter_config_t){.type = type});
+    double worst = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t sorted[FILTER_MEDIAN_MAX_SAMPLES];
+        for (size_t j = 0; j < window; j++) {
+            sorted[j] = input[i >= j ? i - j : 0];
+        }
+        qsort(sorted, window, sizeof(int32_t), bench_compare_int32);
+        worst = fmax(worst, fabs((double)sorted[window / 2] - filter_apply(&filter, input[i])));
+    }
+    return worst;
+}
+
+static double bench_check_biquad(const int32_t* input, size_t n, const filter_config_t* config) {
+    filter_t filter;
+    filter_init(&filter, config);
+
+    const double w0 = 2.0 * M_PI * (config->biquad_cutoff_mhz / 1000.0) / config->biquad_sample_rate_hz;
+    const double alpha = sin(w0) / (2.0 * M_SQRT1_2);
+    const double a0 = 1.0 + alpha;
+    const double b0 = (1.0 - cos(w0)) / 2.0 / a0, b1 = (1.0 - cos(w0)) / a0, b2 = b0;
+    const double a1 = -2.0 * cos(w0) / a0, a2 = (1.0 - alpha) / a0;
+
+    double x1 = input[0], x2 = input[0], y1 = input[0], y2 = input[0];
+    double worst = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        const double y = b0 * input[i] + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = input[i];
+        y2 = y1;
+        y1 = y;
+        worst = fmax(worst, fabs(y - filter_apply(&filter, input[i])));
+    }
+    return worst;
+}
+
+typedef struct bench_case {
+    const char* name;
+    filter_config_t config;
+} bench_case_t;
+
+int main(void) {
+    static int32_t input[BENCH_SAMPLES];
+    bench_make_input(input, BENCH_SAMPLES);
+
+    const filter_config_t biquad = {
+        .type = FILTER_BIQUAD_LOW_PASS, .biquad_cutoff_mhz = 20000, .biquad_sample_rate_hz = 1000};
+
+    // Filters must match the references before their timings mean anything
+    struct {
+        const char* name;
+        double error;
+        double tolerance;
+    } checks[] = {
+        {"ema", bench_check_ema(input, BENCH_SAMPLES, 16384), 1.0},
+        {"median_3", bench_check_median(input, BENCH_SAMPLES, FILTER_MEDIAN_3, 3), 0.0},
+        {"median_5", bench_check_median(input, BENCH_SAMPLES, FILTER_MEDIAN_5, 5), 0.0},
+        {"biquad", bench_check_biquad(input, BENCH_SAMPLES, &biquad), 4.0},
+    };
+    bool passed = true;
+    for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+        if (checks[i].error > checks[i].tolerance) {
+            fprintf(stderr, "%s differs from the reference by %.2f\n", checks[i].name, checks[i].error);
+            passed = false;
+        }
+    }
+    if (!passed) {
+        return EXIT_FAILURE;
+    }
+
+    const bench_case_t cases[] = {
+        {"none", {.type = FILTER_NONE}},
+        {"ema", {.type = FILTER_EMA, .ema_alpha_q16 = 16384}},
+        {"median_3", {.type = FILTER_MEDIAN_3}},
+        {"median_5", {.type = FILTER_MEDIAN_5}},
+        {"biquad", biquad},
+    };
+
+    printf("filter,ns_per_sample,cycles_per_sample\n");
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        filter_t filter;
+        filter_init(&filter, &cases[c].config);
+
+        volatile int32_t sink = 0;
+        const uint64_t start_ns = bench_now_ns();
+        const uint64_t start_cycles = bench_now_cycles();
+        for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+            for (size_t j = 0; j < BENCH_SAMPLES; j++) {
+                sink = filter_apply(&filter, input[j]);
+            }
+        }
+        const uint64_t cycles = bench_now_cycles() - start_cycles;
+        const uint64_t ns = bench_now_ns() - start_ns;
+        (void)sink;
+
+        const double n = (double)BENCH_ITERATIONS * BENCH_SAMPLES;
+        if (BENCH_HAS_CYCLE_COUNTER) {
+            printf("%s,%.2f,%.1f\n", cases[c].name, ns / n, cycles / n);
+        } else {
+            printf("%s,%.2f,\n", cases[c].name, ns / n);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
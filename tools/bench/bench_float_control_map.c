@@ -0,0 +1,10 @@
+#include "bench_float_control_map.h"
+
+// The float reference as an external function, so the firmware build can count
+// the helper calls it makes on target, see helper_calls in src/CMakeLists.txt
+float_output_t float_control_map(const control_settings_t* settings,
+                                 const control_raw_report_t* raw,
+                                 const control_raw_report_t* min,
+                                 const control_raw_report_t* max) {
+    return float_map(settings, raw, min, max);
+}
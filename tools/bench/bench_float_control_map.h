@@ -0,0 +1,65 @@
+#pragma once
+
+// The float control path that the Q16 one replaced, raw sensor values to duty
+// cycles with the calibration applied on every report. bench_control_map
+// compares the Q16 path against it and bench_control_path times both. The
+// firmware build counts the helper calls it makes on target through
+// bench_float_control_map.c.
+
+#include "control/control_map.h"
+#include "util/helpers.h"
+
+typedef struct float_output {
+    float forward, left, right, hand_brake;
+} float_output_t;
+
+static float float_scale_to_0_1(float current_raw, float min_raw, float max_raw) {
+    if (max_raw == min_raw) {
+        return 0;
+    }
+    float value = (current_raw - min_raw) / (max_raw - min_raw);
+    value = MAX_OF(value, 0.0);
+    value = MIN_OF(value, 1.0);
+    return value;
+}
+
+static void float_map_tiller(const control_settings_t* config, float input, float* side, float* handbrake) {
+    *side = 0.0;
+    *handbrake = 0.0;
+    if (input < config->tiller_deadzone) {
+        return;
+    }
+    *side = (input - config->tiller_deadzone) / (config->tiller_max_turn_threshold - config->tiller_deadzone);
+    *side = MIN_OF(*side, 1.0);
+    if (input > config->tiller_handbrake_threshold_begin) {
+        *handbrake = (input - config->tiller_handbrake_threshold_begin) /
+                     (config->tiller_handbrake_threshold_end - config->tiller_handbrake_threshold_begin);
+        *handbrake = MIN_OF(*handbrake, 1.0);
+    }
+}
+
+static float float_map_pedal(const control_settings_t* config, float input) {
+    if (input < config->pedal_deadzone) {
+        return 0.0;
+    }
+    float pwm = (input - config->pedal_deadzone) / (1.0 - config->pedal_deadzone);
+    return MIN_OF(pwm, 1.0);
+}
+
+static float_output_t float_map(const control_settings_t* config,
+                                const control_raw_report_t* raw,
+                                const control_raw_report_t* min,
+                                const control_raw_report_t* max) {
+    const float accelerator = 1.0 - float_scale_to_0_1(raw->accelerator, min->accelerator, max->accelerator);
+    const float left = float_scale_to_0_1(raw->left_tiller, min->left_tiller, max->left_tiller);
+    const float right = float_scale_to_0_1(raw->right_tiller, min->right_tiller, max->right_tiller);
+
+    float_output_t output = {
+        .forward = float_map_pedal(config, accelerator), .left = 0.0, .right = 0.0, .hand_brake = 0.0};
+    float left_handbrake = 0.0;
+    float right_handbrake = 0.0;
+    float_map_tiller(config, left, &output.left, &left_handbrake);
+    float_map_tiller(config, right, &output.right, &right_handbrake);
+    output.hand_brake = MAX_OF(left_handbrake, right_handbrake);
+    return output;
+}
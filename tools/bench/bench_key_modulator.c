@@ -0,0 +1,321 @@
+// Checks usb_keyboard/key_modulator.h against the keyboard task's report
+// timing. Measures the duty cycle each key actually gets, the shortest presses
+// and releases, and the latency of a step in the target against the fixed
+// period software PWM it replaced. Then runs the modulator the way the task
+// now does, woken only at the transitions key_modulator_next_toggle() asks
+// for, and counts the wakes that did not change the key. Last it samples the
+// key the way a game with a fixed tick would, with presses quantised to that
+// tick and without. Results are CSV on stdout, and a duty error past
+// tolerance, a press or release shorter than configured, a step that is
+// slower than the old PWM, wasted wakes or a quantised key the game sees
+// drifting from its duty cycle fail the run.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "usb_keyboard/key_modulator.h"
+#include "util/fixed.h"
+
+#define BENCH_REPORT_US 10000       // Keyboard task interval
+#define BENCH_PWM_PERIOD_US 100000  // Period of the old software PWM
+#define BENCH_MIN_PRESS_US 20000
+#define BENCH_MIN_RELEASE_US 20000
+#define BENCH_DUTY_RUN_US 60000000  // Long enough for the slowest duty cycles to average out
+#define BENCH_DUTY_TOLERANCE 0.005
+#define BENCH_STEP_PHASES 100  // Step arrival times spread over one old PWM period
+#define BENCH_STEP_TIMEOUT_US 2000000
+#define BENCH_GAME_RUN_US 60000000
+#define BENCH_GAME_WINDOW_TICKS 60  // Observed duty is judged over this many game ticks
+#define BENCH_GAME_PHASES 8         // Game tick phases against the modulator, spread over a tick
+#define BENCH_WAKE_JITTER_US 1000   // Alarm latency and the wait for the next USB frame
+#define BENCH_GAME_ROUNDING_TICKS 0.05  // Room for the duty cycle's rounding to Q16 over a run
+
+static const key_modulator_config_t bench_config = {
+    .min_press_us = BENCH_MIN_PRESS_US, .min_release_us = BENCH_MIN_RELEASE_US, .consumer_tick_us = 0};
+
+// Furthest a quantised key's pressed ticks may stray from its duty cycle. The
+// modulator bounds its error to the longer minimum width rounded up to whole
+// ticks, which is one tick where both widths fit in a tick.
+static double bench_game_bound_ticks(uint32_t tick_us) {
+    const uint32_t width_us = BENCH_MIN_PRESS_US > BENCH_MIN_RELEASE_US ? BENCH_MIN_PRESS_US : BENCH_MIN_RELEASE_US;
+    const uint32_t ticks = (width_us + tick_us - 1) / tick_us;
+    return (ticks < 1 ? 1 : ticks) + BENCH_GAME_ROUNDING_TICKS;
+}
+
+// The old keyboard task, which only took up a new output when a period started
+typedef struct bench_pwm {
+    uint32_t period_start_us;
+    q16_t duty_cycle;
+} bench_pwm_t;
+
+static bool bench_pwm_update(bench_pwm_t* pwm, q16_t pending, uint32_t now_us) {
+    uint32_t elapsed_us = now_us - pwm->period_start_us;
+    if (elapsed_us > BENCH_PWM_PERIOD_US) {
+        pwm->period_start_us = now_us;
+        pwm->duty_cycle = pending;
+        elapsed_us = 0;
+    }
+    return q16_ratio(elapsed_us, BENCH_PWM_PERIOD_US) <= pwm->duty_cycle && Q16_ZERO != pwm->duty_cycle;
+}
+
+typedef struct bench_duty_result {
+    double duty;
+    uint32_t shortest_press_us;
+    uint32_t shortest_release_us;
+} bench_duty_result_t;
+
+// Runs one key at a steady `duty_cycle` and measures what it got
+static bench_duty_result_t bench_duty(q16_t duty_cycle) {
+    key_modulator_t modulator;
+    key_modulator_init(&modulator);
+
+    uint64_t held_us = 0;
+    bool pressed = false;
+    uint32_t changed_us = 0;
+    bool first_state = true;  // Its length depends on the start, not the modulator
+    bench_duty_result_t result = {.shortest_press_us = UINT32_MAX, .shortest_release_us = UINT32_MAX};
+    for (uint32_t now_us = 0; now_us < BENCH_DUTY_RUN_US; now_us += BENCH_REPORT_US) {
+        const bool now_pressed = key_modulator_update(&modulator, &bench_config, duty_cycle, now_us);
+        if (now_pressed != pressed) {
+            uint32_t* shortest = pressed ? &result.shortest_press_us : &result.shortest_release_us;
+            if (!first_state && now_us - changed_us < *shortest) {
+                *shortest = now_us - changed_us;
+            }
+            pressed = now_pressed;
+            changed_us = now_us;
+            first_state = false;
+        }
+        held_us += now_pressed ? BENCH_REPORT_US : 0;
+    }
+    result.duty = (double)held_us / BENCH_DUTY_RUN_US;
+    return result;
+}
+
+typedef struct bench_scheduled_result {
+    double duty;
+    uint32_t transitions;
+    uint32_t wakes;
+} bench_scheduled_result_t;
+
+// Runs one key at a steady `duty_cycle`, waking only when the modulator says it will toggle
+static bench_scheduled_result_t bench_scheduled(q16_t duty_cycle) {
+    key_modulator_t modulator;
+    key_modulator_init(&modulator);
+
+    bench_scheduled_result_t result = {0};
+    uint64_t held_us = 0;
+    uint32_t now_us = 0;
+    bool pressed = key_modulator_update(&modulator, &bench_config, duty_cycle, now_us);
+    while (now_us < BENCH_DUTY_RUN_US) {
+        uint32_t toggle_us;
+        const uint32_t next_us = key_modulator_next_toggle(&modulator, &bench_config, duty_cycle, &toggle_us)
+                                     ? (toggle_us < BENCH_DUTY_RUN_US ? toggle_us : BENCH_DUTY_RUN_US)
+                                     : BENCH_DUTY_RUN_US;
+        held_us += pressed ? next_us - now_us : 0;
+        now_us = next_us;
+        if (now_us >= BENCH_DUTY_RUN_US) {
+            break;
+        }
+
+        const bool now_pressed = key_modulator_update(&modulator, &bench_config, duty_cycle, now_us);
+        result.wakes++;
+        result.transitions += now_pressed != pressed ? 1 : 0;
+        pressed = now_pressed;
+    }
+    result.duty = (double)held_us / BENCH_DUTY_RUN_US;
+    return result;
+}
+
+typedef struct bench_step_result {
+    double mean_ms;
+    double worst_ms;
+} bench_step_result_t;
+
+static void bench_step_add(bench_step_result_t* result, uint32_t latency_us) {
+    result->mean_ms += latency_us / 1e3 / BENCH_STEP_PHASES;
+    result->worst_ms = fmax(result->worst_ms, latency_us / 1e3);
+}
+
+// Latency from the target stepping from `from` to `to` until the key first
+// shows the new target, pressed for a rise and released for a fall
+static void bench_step(q16_t from, q16_t to, bench_step_result_t* modulated, bench_step_result_t* pwm_result) {
+    const bool rising = to > from;
+    for (uint32_t phase = 0; phase < BENCH_STEP_PHASES; phase++) {
+        const uint32_t step_us = 1000000 + phase * (BENCH_PWM_PERIOD_US / BENCH_STEP_PHASES);
+
+        key_modulator_t modulator;
+        key_modulator_init(&modulator);
+        bench_pwm_t pwm = {.period_start_us = 0, .duty_cycle = from};
+        uint32_t modulated_us = 0;
+        uint32_t pwm_us = 0;
+        for (uint32_t now_us = 0; now_us < step_us + BENCH_STEP_TIMEOUT_US; now_us += BENCH_REPORT_US) {
+            const q16_t target = now_us >= step_us ? to : from;
+            const bool modulated_pressed = key_modulator_update(&modulator, &bench_config, target, now_us);
+            const bool pwm_pressed = bench_pwm_update(&pwm, target, now_us);
+            if (now_us < step_us) {
+                continue;
+            }
+            if (0 == modulated_us && modulated_pressed == rising) {
+                modulated_us = now_us - step_us + 1;
+            }
+            if (0 == pwm_us && pwm_pressed == rising) {
+                pwm_us = now_us - step_us + 1;
+            }
+            if (0 != modulated_us && 0 != pwm_us) {
+                break;
+            }
+        }
+        bench_step_add(modulated, 0 == modulated_us ? BENCH_STEP_TIMEOUT_US : modulated_us - 1);
+        bench_step_add(pwm_result, 0 == pwm_us ? BENCH_STEP_TIMEOUT_US : pwm_us - 1);
+    }
+}
+
+typedef struct bench_fidelity_result {
+    double duty;               // As the game saw it
+    double worst_window_ticks; // Furthest a window of game ticks was from the requested duty, in ticks
+    double worst_drift_ticks;  // Furthest the pressed ticks so far were from the requested duty
+} bench_fidelity_result_t;
+
+// Runs one key at a steady `duty_cycle`, woken at each toggle with some
+// jitter, and samples it the way a game with `tick_us` ticks would. The game's
+// ticks are `phase_us` after the modulator's, which should be more than the
+// jitter, or whether a tick sees a toggle is down to the wake.
+static bench_fidelity_result_t bench_fidelity(q16_t duty_cycle, uint32_t tick_us, bool quantise, uint32_t phase_us) {
+    key_modulator_config_t config = bench_config;
+    config.consumer_tick_us = quantise ? tick_us : 0;
+    key_modulator_t modulator;
+    key_modulator_init(&modulator);
+
+    uint32_t state = 2654435761u * (phase_us + 1);
+    const double duty = q16_to_float(duty_cycle);
+    uint32_t samples = 0;
+    uint32_t pressed_samples = 0;
+    uint32_t window_pressed = 0;
+    bench_fidelity_result_t result = {0};
+
+    uint32_t sample_us = phase_us;
+    uint32_t now_us = 0;
+    bool pressed = key_modulator_update(&modulator, &config, duty_cycle, now_us);
+    while (now_us < BENCH_GAME_RUN_US) {
+        uint32_t toggle_us;
+        uint32_t next_us = BENCH_GAME_RUN_US;
+        if (key_modulator_next_toggle(&modulator, &config, duty_cycle, &toggle_us)) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            next_us = toggle_us + state % BENCH_WAKE_JITTER_US;
+        }
+
+        // The game sees the key as it is until the task next wakes
+        for (; sample_us < next_us && sample_us < BENCH_GAME_RUN_US; sample_us += tick_us) {
+            samples++;
+            pressed_samples += pressed ? 1 : 0;
+            window_pressed += pressed ? 1 : 0;
+            if (0 == samples % BENCH_GAME_WINDOW_TICKS) {
+                result.worst_window_ticks =
+                    fmax(result.worst_window_ticks, fabs(window_pressed - duty * BENCH_GAME_WINDOW_TICKS));
+                window_pressed = 0;
+            }
+            result.worst_drift_ticks = fmax(result.worst_drift_ticks, fabs(pressed_samples - duty * samples));
+        }
+
+        now_us = next_us;
+        pressed = key_modulator_update(&modulator, &config, duty_cycle, now_us);
+    }
+    result.duty = (double)pressed_samples / samples;
+    return result;
+}
+
+int main(void) {
+    bool failed = false;
+
+    printf("duty,measured,error,shortest_press_ms,shortest_release_ms\n");
+    for (int percent = 0; percent <= 100; percent += 5) {
+        const q16_t duty_cycle = q16_ratio(percent, 100);
+        const bench_duty_result_t result = bench_duty(duty_cycle);
+        const double error = result.duty - percent / 100.0;
+        printf("%.2f,%.4f,%+.4f,%.0f,%.0f\n", percent / 100.0, result.duty, error,
+               UINT32_MAX == result.shortest_press_us ? 0.0 : result.shortest_press_us / 1e3,
+               UINT32_MAX == result.shortest_release_us ? 0.0 : result.shortest_release_us / 1e3);
+        if (fabs(error) > BENCH_DUTY_TOLERANCE) {
+            fprintf(stderr, "duty %d%%: measured %.4f\n", percent, result.duty);
+            failed = true;
+        }
+        if ((UINT32_MAX != result.shortest_press_us && result.shortest_press_us < BENCH_MIN_PRESS_US) ||
+            (UINT32_MAX != result.shortest_release_us && result.shortest_release_us < BENCH_MIN_RELEASE_US)) {
+            fprintf(stderr, "duty %d%%: press or release shorter than configured\n", percent);
+            failed = true;
+        }
+    }
+
+    printf("\nduty,scheduled_measured,error,transitions_per_s,wakes_per_s,polled_wakes_per_s\n");
+    for (int percent = 0; percent <= 100; percent += 5) {
+        const q16_t duty_cycle = q16_ratio(percent, 100);
+        const bench_scheduled_result_t result = bench_scheduled(duty_cycle);
+        const double error = result.duty - percent / 100.0;
+        const double seconds = BENCH_DUTY_RUN_US / 1e6;
+        printf("%.2f,%.4f,%+.4f,%.1f,%.1f,%.1f\n", percent / 100.0, result.duty, error, result.transitions / seconds,
+               result.wakes / seconds, 1e6 / BENCH_REPORT_US);
+        if (fabs(error) > BENCH_DUTY_TOLERANCE) {
+            fprintf(stderr, "scheduled duty %d%%: measured %.4f\n", percent, result.duty);
+            failed = true;
+        }
+        if (result.wakes > result.transitions + result.transitions / 100 + 2) {
+            fprintf(stderr, "scheduled duty %d%%: %u wakes for %u transitions\n", percent, result.wakes,
+                    result.transitions);
+            failed = true;
+        }
+    }
+
+    printf("\nfrom,to,modulated_mean_ms,modulated_worst_ms,pwm_mean_ms,pwm_worst_ms\n");
+    static const int steps[][2] = {{0, 100}, {0, 50}, {0, 20}, {100, 0}, {50, 0}, {20, 80}, {80, 20}};
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        bench_step_result_t modulated = {0};
+        bench_step_result_t pwm = {0};
+        bench_step(q16_ratio(steps[i][0], 100), q16_ratio(steps[i][1], 100), &modulated, &pwm);
+        printf("%.2f,%.2f,%.1f,%.1f,%.1f,%.1f\n", steps[i][0] / 100.0, steps[i][1] / 100.0, modulated.mean_ms,
+               modulated.worst_ms, pwm.mean_ms, pwm.worst_ms);
+        if (modulated.mean_ms > pwm.mean_ms) {
+            fprintf(stderr, "step %d%% to %d%%: slower than the old PWM\n", steps[i][0], steps[i][1]);
+            failed = true;
+        }
+    }
+
+    printf("\ngame_hz,duty,quantised_bound_ticks,quantised_observed,quantised_worst_window_ticks,"
+           "quantised_worst_drift_ticks,free_observed,free_worst_window_ticks,free_worst_drift_ticks\n");
+    static const uint32_t game_ticks_us[] = {16667, 33333, 50000};
+    for (size_t i = 0; i < sizeof(game_ticks_us) / sizeof(game_ticks_us[0]); i++) {
+        const uint32_t tick_us = game_ticks_us[i];
+        const double bound_ticks = bench_game_bound_ticks(tick_us);
+        for (int percent = 10; percent <= 90; percent += 10) {
+            const q16_t duty_cycle = q16_ratio(percent, 100);
+            bench_fidelity_result_t quantised = {.duty = 0.0, .worst_window_ticks = 0.0};
+            bench_fidelity_result_t free = quantised;
+            // Phases are off the modulator's tick edges, see bench_fidelity()
+            for (uint32_t phase = 0; phase < BENCH_GAME_PHASES; phase++) {
+                const uint32_t phase_us = (2 * phase + 1) * tick_us / (2 * BENCH_GAME_PHASES);
+                const bench_fidelity_result_t q = bench_fidelity(duty_cycle, tick_us, true, phase_us);
+                const bench_fidelity_result_t f = bench_fidelity(duty_cycle, tick_us, false, phase_us);
+                quantised.duty += q.duty / BENCH_GAME_PHASES;
+                quantised.worst_window_ticks = fmax(quantised.worst_window_ticks, q.worst_window_ticks);
+                free.duty += f.duty / BENCH_GAME_PHASES;
+                free.worst_window_ticks = fmax(free.worst_window_ticks, f.worst_window_ticks);
+                quantised.worst_drift_ticks = fmax(quantised.worst_drift_ticks, q.worst_drift_ticks);
+                free.worst_drift_ticks = fmax(free.worst_drift_ticks, f.worst_drift_ticks);
+            }
+            printf("%.1f,%.2f,%.2f,%.4f,%.2f,%.2f,%.4f,%.2f,%.2f\n", 1e6 / tick_us, percent / 100.0, bound_ticks,
+                   quantised.duty, quantised.worst_window_ticks, quantised.worst_drift_ticks, free.duty,
+                   free.worst_window_ticks, free.worst_drift_ticks);
+            if (quantised.worst_window_ticks > bound_ticks || quantised.worst_drift_ticks > bound_ticks) {
+                fprintf(stderr, "game at %u us, duty %d%%: quantised key drifted from its duty cycle\n", tick_us,
+                        percent);
+                failed = true;
+            }
+        }
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
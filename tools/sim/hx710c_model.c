@@ -0,0 +1,127 @@
+#include "hx710c_model.h"
+
+#include <string.h>
+
+static void hx710c_model_set_dout(hx710c_model_t* model, bool level, uint64_t time_ps) {
+    if (model->dout != level) {
+        vgpio_log_input(model->device.pin, level, time_ps);
+    }
+    model->dout = level;
+    model->dout_next = level;
+    model->dout_change_ps = time_ps;
+}
+
+static void hx710c_model_update(void* context, uint64_t now_ps) {
+    hx710c_model_t* const model = context;
+
+    // Apply pending DOUT changes
+    if (model->dout_next != model->dout && now_ps >= model->dout_change_ps) {
+        hx710c_model_set_dout(model, model->dout_next, model->dout_change_ps);
+    }
+
+    // A readout ends once SCL has idled low for long enough, the pulse count picks the next conversion
+    if (HX710C_MODEL_SHIFTING == model->state && !model->scl && model->n_pulses >= 25 &&
+        now_ps - model->scl_edge_ps >= HX710C_MODEL_READOUT_END_PS) {
+        switch (model->n_pulses) {
+            case 25:
+                model->mode = HX710C_MODEL_DIFFERENTIAL_10HZ;
+                break;
+            case 26:
+                model->mode = HX710C_MODEL_AUX_40HZ;
+                break;
+            default:
+                model->mode = HX710C_MODEL_DIFFERENTIAL_40HZ;
+                break;
+        }
+        model->last_value_shifted = model->value;
+        model->n_readouts++;
+        model->state = HX710C_MODEL_CONVERTING;
+        model->ready_at_ps = model->scl_edge_ps + hx710c_model_period_ps(model->mode);
+        model->n_pulses = 0;
+    }
+
+    // Conversion ready
+    if (HX710C_MODEL_CONVERTING == model->state && now_ps >= model->ready_at_ps) {
+        model->value = HX710C_MODEL_AUX_40HZ == model->mode
+                           ? HX710C_MODEL_AUX_VALUE
+                           : hx710c_model_differential_value(model, model->n_conversions);
+        model->last_value_mode = model->mode;
+        model->n_conversions++;
+        model->state = HX710C_MODEL_READY;
+        hx710c_model_set_dout(model, false, model->ready_at_ps);
+    }
+}
+
+static bool hx710c_model_level(void* context, uint64_t now_ps, bool sampled) {
+    (void)sampled;
+    hx710c_model_t* const model = context;
+
+    // Sampling before DOUT settles sees the previous bit
+    hx710c_model_update(model, now_ps);
+    return model->dout;
+}
+
+static void hx710c_model_on_output(void* context, uint8_t pin, bool level, uint64_t now_ps) {
+    hx710c_model_t* const model = context;
+    if (pin != model->scl_pin) {
+        return;
+    }
+    hx710c_model_update(model, now_ps);
+
+    if (!level) {
+        if (now_ps - model->scl_edge_ps >= HX710C_MODEL_POWER_DOWN_PS) {
+            model->n_power_downs++;
+        }
+        model->scl = false;
+        model->scl_edge_ps = now_ps;
+        return;
+    }
+    model->scl = true;
+    model->scl_edge_ps = now_ps;
+
+    // Clocks while converting do nothing
+    if (HX710C_MODEL_CONVERTING == model->state) {
+        model->n_ignored_pulses++;
+        return;
+    }
+
+    model->state = HX710C_MODEL_SHIFTING;
+    model->n_pulses++;
+    if (model->n_pulses <= 24) {
+        // Shift out the next bit, MSB first
+        model->dout_next = (((uint32_t)model->value) >> (24 - model->n_pulses)) & 0x1;
+        model->dout_change_ps = now_ps + HX710C_MODEL_T2_PS;
+    } else if (25 == model->n_pulses) {
+        model->dout_next = true;
+        model->dout_change_ps = now_ps + HX710C_MODEL_T2_PS;
+    }
+}
+
+void hx710c_model_init(hx710c_model_t* model, uint8_t scl_pin, uint8_t sda_pin, uint32_t seed,
+                       uint64_t first_ready_ps) {
+    memset(model, 0, sizeof(hx710c_model_t));
+    model->scl_pin = scl_pin;
+    model->seed = seed;
+    model->state = HX710C_MODEL_CONVERTING;
+    model->mode = HX710C_MODEL_DIFFERENTIAL_10HZ;
+    model->ready_at_ps = first_ready_ps;
+    model->dout = true;
+    model->dout_next = true;
+
+    model->device = (vgpio_device_t){.pin = sda_pin,
+                                     .context = model,
+                                     .update = hx710c_model_update,
+                                     .level = hx710c_model_level,
+                                     .on_output = hx710c_model_on_output};
+    vgpio_attach(&model->device);
+}
+
+int32_t hx710c_model_differential_value(const hx710c_model_t* model, uint32_t n) {
+    // Walk the full 24 bit range, both signs included
+    const uint32_t raw = (model->seed * 2654435761u + (n + 1) * 40503u * (model->seed + 1)) & 0x00FFFFFF;
+    return (raw & 0x800000) ? (int32_t)(raw | 0xFF000000) : (int32_t)raw;
+}
+
+uint64_t hx710c_model_period_ps(hx710c_model_mode_t mode) {
+    return HX710C_MODEL_DIFFERENTIAL_10HZ == mode ? 100 * VGPIO_PS_PER_MS : 25 * VGPIO_PS_PER_MS;
+}
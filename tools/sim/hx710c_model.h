@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "virtual_gpio.h"
+
+// Behavioural model of a single HX710C on the virtual GPIO bank.
+//
+// DOUT idles high while converting and falls when a conversion is ready. Each
+// SCL rising edge shifts out the next bit, MSB first, valid T2 after the edge.
+// The 25th edge pulls DOUT high again, and the number of pulses in the readout
+// selects the next conversion: 25 differential at 10Hz, 26 the auxiliary input
+// at 40Hz, 27 differential at 40Hz. Holding SCL high for too long powers the
+// device down.
+
+#define HX710C_MODEL_T2_PS (100 * VGPIO_PS_PER_NS)
+#define HX710C_MODEL_POWER_DOWN_PS (60 * VGPIO_PS_PER_US)
+
+// SCL idle for this long ends a readout
+#define HX710C_MODEL_READOUT_END_PS (10 * VGPIO_PS_PER_US)
+
+// Value converted from the auxiliary input
+#define HX710C_MODEL_AUX_VALUE 0x123456
+
+typedef enum hx710c_model_mode {
+    HX710C_MODEL_DIFFERENTIAL_10HZ,
+    HX710C_MODEL_AUX_40HZ,
+    HX710C_MODEL_DIFFERENTIAL_40HZ,
+} hx710c_model_mode_t;
+
+typedef enum hx710c_model_state {
+    HX710C_MODEL_CONVERTING,
+    HX710C_MODEL_READY,
+    HX710C_MODEL_SHIFTING,
+} hx710c_model_state_t;
+
+typedef struct hx710c_model {
+    vgpio_device_t device;
+    uint8_t scl_pin;
+    uint32_t seed;  // Varies the differential values between devices
+
+    hx710c_model_state_t state;
+    hx710c_model_mode_t mode;
+    uint64_t ready_at_ps;
+    uint32_t n_conversions;
+    int32_t value;  // Conversion being shifted out
+
+    // SCL
+    bool scl;
+    uint64_t scl_edge_ps;
+    uint8_t n_pulses;
+
+    // DOUT, changes to `dout_next` at `dout_change_ps`
+    bool dout;
+    bool dout_next;
+    uint64_t dout_change_ps;
+
+    // Results
+    int32_t last_value_shifted;
+    hx710c_model_mode_t last_value_mode;
+    uint32_t n_readouts;
+    uint32_t n_ignored_pulses;  // Pulses while no conversion was ready
+    uint32_t n_power_downs;
+} hx710c_model_t;
+
+// Initialises the model and attaches it to `sda_pin`. The first conversion is
+// ready at `first_ready_ps`.
+void hx710c_model_init(hx710c_model_t* model, uint8_t scl_pin, uint8_t sda_pin, uint32_t seed,
+                       uint64_t first_ready_ps);
+
+// Returns the differential value of the model's nth conversion, as a 24 bit two's complement
+int32_t hx710c_model_differential_value(const hx710c_model_t* model, uint32_t n);
+
+// Returns the conversion period of `mode`
+uint64_t hx710c_model_period_ps(hx710c_model_mode_t mode);
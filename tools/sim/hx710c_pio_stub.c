@@ -0,0 +1,97 @@
+#include "control/hx710c_pio.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "util/bit_transpose.h"
+#include "util/tank_assert.h"
+#include "virtual_pio.h"
+
+// The PIO engine on the virtual GPIO bank. The state machine runs the
+// firmware's own hx710c.pio, configured as hx710c_program_init() does, and
+// DMA is modelled as always keeping up with the RX FIFO, so each conversion
+// lands in the ping-pong buffers as soon as its last word is pushed.
+
+#define HX710C_PIO_WORDS_PER_CONVERSION 24
+#define HX710C_PIO_N_BUFFERS 2
+#define HX710C_PIO_CYCLE_HZ 10000000
+
+struct hx710c_pio_engine {
+    vpio_program_t program;
+    vpio_sm_t sm;
+    uint32_t buffers[HX710C_PIO_N_BUFFERS][HX710C_PIO_WORDS_PER_CONVERSION];
+    uint8_t filling_buffer;
+    uint8_t n_words;
+
+    uint8_t latest_buffer;
+    uint32_t sequence;
+    void (*ready_callback)(void*);
+    void* ready_callback_context;
+    uint32_t read_sequence;
+};
+
+static hx710c_pio_engine_t hx710c_pio_engine;
+
+// Stands in for the DMA channels and their IRQ
+static void hx710c_pio_push(void* context, uint32_t word) {
+    hx710c_pio_engine_t* const engine = context;
+    engine->buffers[engine->filling_buffer][engine->n_words++] = word;
+    if (HX710C_PIO_WORDS_PER_CONVERSION != engine->n_words) {
+        return;
+    }
+    engine->latest_buffer = engine->filling_buffer;
+    engine->filling_buffer = (engine->filling_buffer + 1) % HX710C_PIO_N_BUFFERS;
+    engine->n_words = 0;
+    engine->sequence++;
+    if (NULL != engine->ready_callback) {
+        engine->ready_callback(engine->ready_callback_context);
+    }
+}
+
+// Each simulator run starts with vgpio_reset(), which detaches the engine of the run before
+hx710c_pio_engine_t* hx710c_pio_start(PIO pio, uint8_t scl_pin, uint8_t sda_base_pin, uint8_t n_devices) {
+    (void)pio;
+    hx710c_pio_engine_t* const engine = &hx710c_pio_engine;
+    memset(engine, 0, sizeof(hx710c_pio_engine_t));
+    vpio_assemble(&engine->program, HX710C_PIO_SOURCE);
+
+    // As hx710c_program_init(), enter and wrap back to the wait for the last device
+    const uint32_t max_devices = vpio_symbol(&engine->program, "MAX_DEVICES");
+    TANK_ASSERT_M(n_devices >= 1 && n_devices <= max_devices, "The HX710C PIO program waits for at most %u devices",
+                  max_devices);
+    const uint8_t entry = (uint8_t)(vpio_symbol(&engine->program, "wait_first") - (n_devices - 1));
+    vpio_sm_start(&engine->sm, &engine->program, entry, entry, engine->program.wrap, sda_base_pin, scl_pin,
+                  HX710C_PIO_CYCLE_HZ, hx710c_pio_push, engine);
+
+    return engine;
+}
+
+// As hx710c_pio.c, without the retry as nothing runs concurrently here
+bool hx710c_pio_read(hx710c_pio_engine_t* engine, uint8_t n_devices, uint32_t* raw_conversions,
+                     uint32_t* missed_conversions) {
+    if (engine->sequence == engine->read_sequence) {
+        return false;
+    }
+    *missed_conversions += engine->sequence - engine->read_sequence - 1;
+    engine->read_sequence = engine->sequence;
+
+    const uint32_t* const words = engine->buffers[engine->latest_buffer];
+    const uint32_t device_mask = n_devices < 32 ? (1u << n_devices) - 1 : 0xFFFFFFFF;
+    uint32_t bit_planes[32] = {0};
+    for (uint8_t i = 0; i < HX710C_PIO_WORDS_PER_CONVERSION; i++) {
+        bit_planes[HX710C_PIO_WORDS_PER_CONVERSION - 1 - i] = words[i] & device_mask;
+    }
+    bit_transpose_32x32(bit_planes);
+    memcpy(raw_conversions, bit_planes, n_devices * sizeof(uint32_t));
+
+    return true;
+}
+
+bool hx710c_pio_is_ready(const hx710c_pio_engine_t* engine) {
+    return engine->sequence != engine->read_sequence;
+}
+
+void hx710c_pio_set_ready_callback(hx710c_pio_engine_t* engine, void (*callback)(void*), void* context) {
+    engine->ready_callback_context = context;
+    engine->ready_callback = callback;
+}
@@ -0,0 +1,295 @@
+// Runs the HX710C driver against modelled devices on a virtual GPIO bank, both
+// bit-banged and with the PIO program clocking conversions out. The devices
+// become ready a little apart, so a readout that starts before all of them
+// have a conversion is caught. Every SCL/SDA transition is recorded and
+// checked against the datasheet T1-T4 limits, every conversion read is
+// checked against what the models shifted out, and the bus time of each read
+// is reported.
+//
+// Prints one CSV row per clock speed and channel count. Exits with a failure if
+// any check failed.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "control/hx710c.h"
+#include "hx710c_model.h"
+#include "util/timing.h"
+#include "virtual_gpio.h"
+
+// Datasheet limits
+#define SIM_T1_MIN_PS (100 * VGPIO_PS_PER_NS)
+#define SIM_T2_MAX_PS (100 * VGPIO_PS_PER_NS)
+#define SIM_T3_MIN_PS (200 * VGPIO_PS_PER_NS)
+#define SIM_T3_MAX_PS (50 * VGPIO_PS_PER_US)
+#define SIM_T4_MIN_PS (200 * VGPIO_PS_PER_NS)
+
+// SCL low for longer than this separates readouts
+#define SIM_READOUT_GAP_PS VGPIO_PS_PER_MS
+
+#define SIM_SCL_PIN 1
+#define SIM_FIRST_SDA_PIN 2
+#define SIM_MAX_CHANNELS 16
+#define SIM_N_READS 8
+#define SIM_POLL_INTERVAL_PS (100 * VGPIO_PS_PER_US)
+#define SIM_READY_TIMEOUT_PS (30 * VGPIO_PS_PER_MS)
+
+typedef enum sim_wait {
+    SIM_WAIT_POLL,      // Bit-banged, polling hx710c_is_ready()
+    SIM_WAIT_DRDY_IRQ,  // Bit-banged, woken by the DRDY interrupt
+    SIM_WAIT_PIO,       // Clocked out by PIO, woken as each conversion lands
+} sim_wait_t;
+
+static const char* const sim_wait_names[] = {"poll", "drdy_irq", "pio"};
+
+typedef struct sim_timing_report {
+    uint64_t t1_min_ps;
+    uint64_t t2_min_ps;
+    uint64_t t3_min_ps;
+    uint64_t t3_max_ps;
+    uint64_t t4_min_ps;
+    uint32_t n_violations;
+} sim_timing_report_t;
+
+static hx710c_t sim_device;
+static hx710c_model_t sim_models[SIM_MAX_CHANNELS];
+static uint8_t sim_sda_pins[SIM_MAX_CHANNELS];
+static uint32_t sim_n_callbacks;
+
+static void sim_ready_callback(void* context) {
+    (void)context;
+    sim_n_callbacks++;
+}
+
+static double sim_ps_to_ns(uint64_t ps) {
+    return (double)ps / VGPIO_PS_PER_NS;
+}
+
+static void sim_violation(sim_timing_report_t* report, const char* timing, uint64_t time_ps, uint64_t measured_ps) {
+    fprintf(stderr, "  %s violated at %.3fus, measured %.1fns\n", timing, sim_ps_to_ns(time_ps) / 1000.0,
+            sim_ps_to_ns(measured_ps));
+    report->n_violations++;
+}
+
+// Walks the recorded waveform checking T1-T4
+static sim_timing_report_t sim_check_timing(uint8_t n_channels) {
+    sim_timing_report_t report = {.t1_min_ps = UINT64_MAX, .t2_min_ps = UINT64_MAX, .t3_min_ps = UINT64_MAX,
+                                  .t4_min_ps = UINT64_MAX};
+
+    bool sda_levels[VGPIO_N_PINS];
+    uint64_t sda_fall_ps[VGPIO_N_PINS] = {0};
+    for (uint8_t pin = 0; pin < VGPIO_N_PINS; pin++) {
+        sda_levels[pin] = true;
+    }
+    bool scl = false;
+    bool scl_seen = false;
+    uint64_t scl_rise_ps = 0;
+    uint64_t scl_fall_ps = 0;
+
+    size_t n_events;
+    const vgpio_event_t* events = vgpio_events(&n_events);
+    for (size_t i = 0; i < n_events; i++) {
+        const vgpio_event_t* const event = &events[i];
+        switch (event->kind) {
+            case VGPIO_EVENT_INPUT:
+                if (sda_levels[event->pin] && !event->level) {
+                    sda_fall_ps[event->pin] = event->time_ps;
+                }
+                sda_levels[event->pin] = event->level;
+                break;
+
+            case VGPIO_EVENT_SAMPLE:
+                // T2, DOUT is only valid some time after SCL rises
+                if (scl) {
+                    const uint64_t t2 = event->time_ps - scl_rise_ps;
+                    report.t2_min_ps = t2 < report.t2_min_ps ? t2 : report.t2_min_ps;
+                    if (t2 < SIM_T2_MAX_PS) {
+                        sim_violation(&report, "T2", event->time_ps, t2);
+                    }
+                }
+                break;
+
+            case VGPIO_EVENT_OUTPUT:
+                if (SIM_SCL_PIN != event->pin) {
+                    break;
+                }
+                if (event->level) {
+                    const bool readout_start = !scl_seen || event->time_ps - scl_fall_ps >= SIM_READOUT_GAP_PS;
+                    if (!readout_start) {
+                        // T4, SCL low between pulses
+                        const uint64_t t4 = event->time_ps - scl_fall_ps;
+                        report.t4_min_ps = t4 < report.t4_min_ps ? t4 : report.t4_min_ps;
+                        if (t4 < SIM_T4_MIN_PS) {
+                            sim_violation(&report, "T4", event->time_ps, t4);
+                        }
+                    } else {
+                        // T1, only for readouts, pulses while any device is converting just select the mode
+                        bool all_ready = true;
+                        uint64_t last_ready_ps = 0;
+                        for (uint8_t c = 0; c < n_channels; c++) {
+                            all_ready &= !sda_levels[sim_sda_pins[c]];
+                            if (sda_fall_ps[sim_sda_pins[c]] > last_ready_ps) {
+                                last_ready_ps = sda_fall_ps[sim_sda_pins[c]];
+                            }
+                        }
+                        if (all_ready) {
+                            const uint64_t t1 = event->time_ps - last_ready_ps;
+                            report.t1_min_ps = t1 < report.t1_min_ps ? t1 : report.t1_min_ps;
+                            if (t1 < SIM_T1_MIN_PS) {
+                                sim_violation(&report, "T1", event->time_ps, t1);
+                            }
+                        }
+                    }
+                    scl_rise_ps = event->time_ps;
+                } else {
+                    // T3, SCL high
+                    const uint64_t t3 = event->time_ps - scl_rise_ps;
+                    report.t3_min_ps = t3 < report.t3_min_ps ? t3 : report.t3_min_ps;
+                    report.t3_max_ps = t3 > report.t3_max_ps ? t3 : report.t3_max_ps;
+                    if (t3 < SIM_T3_MIN_PS) {
+                        sim_violation(&report, "T3 min", event->time_ps, t3);
+                    }
+                    if (t3 > SIM_T3_MAX_PS) {
+                        sim_violation(&report, "T3 max", event->time_ps, t3);
+                    }
+                    scl_fall_ps = event->time_ps;
+                }
+                scl = event->level;
+                scl_seen = true;
+                break;
+        }
+    }
+
+    return report;
+}
+
+// Returns the number of failed checks
+static uint32_t sim_run(uint32_t clk_sys_hz, uint8_t n_channels, sim_wait_t wait) {
+    uint32_t n_errors = 0;
+    const bool use_ready_callback = SIM_WAIT_POLL != wait;
+
+    // Bring up the virtual bank, the models, then the driver
+    vgpio_reset(clk_sys_hz);
+    timing_init();
+    for (uint8_t c = 0; c < n_channels; c++) {
+        sim_sda_pins[c] = SIM_FIRST_SDA_PIN + c;
+
+        // Stagger the devices a little, the driver has to wait for all of them
+        hx710c_model_init(&sim_models[c], SIM_SCL_PIN, sim_sda_pins[c], c,
+                          VGPIO_PS_PER_MS + c * 2 * VGPIO_PS_PER_US);
+    }
+    if (SIM_WAIT_PIO == wait) {
+        hx710c_init_pio(&sim_device, pio0, SIM_SCL_PIN, sim_sda_pins, n_channels);
+    } else {
+        hx710c_init(&sim_device, SIM_SCL_PIN, sim_sda_pins, n_channels);
+    }
+    uint32_t n_ignored_pulses[SIM_MAX_CHANNELS];
+    for (uint8_t c = 0; c < n_channels; c++) {
+        n_ignored_pulses[c] = sim_models[c].n_ignored_pulses;
+    }
+    sim_n_callbacks = 0;
+    if (use_ready_callback) {
+        hx710c_set_ready_callback(&sim_device, sim_ready_callback, NULL);
+    }
+
+    uint64_t bus_time_ps = 0;
+    for (uint32_t read = 0; read < SIM_N_READS; read++) {
+        // Wait like the input task would, on the callback or by polling
+        if (use_ready_callback) {
+            // The DRDY callback only watches the first device. The devices are
+            // out of step until their first readout, so like the input task
+            // fall back to a timeout if the others are not ready yet.
+            const uint64_t timeout_ps = vgpio_now_ps() + SIM_READY_TIMEOUT_PS;
+            while (sim_n_callbacks <= read && vgpio_now_ps() < timeout_ps) {
+                vgpio_advance_to_ps(vgpio_now_ps() + VGPIO_PS_PER_US);
+            }
+        } else {
+            while (!hx710c_is_ready(&sim_device)) {
+                vgpio_advance_to_ps(vgpio_now_ps() + SIM_POLL_INTERVAL_PS);
+            }
+        }
+
+        const uint64_t start_ps = vgpio_now_ps();
+        int32_t conversions[SIM_MAX_CHANNELS] = {0};
+        if (!hx710c_read(&sim_device, conversions)) {
+            if (SIM_WAIT_DRDY_IRQ != wait || 0 != read) {
+                fprintf(stderr, "  Read %u was not ready\n", read);
+                n_errors++;
+            }
+            read--;
+            continue;
+        }
+        bus_time_ps += vgpio_now_ps() - start_ps;
+
+        // The conversions must be what the models shifted out, with 27 pulses to stay at 40Hz. PIO sends the
+        // last pulses after the conversion lands, the mode checked below covers those.
+        for (uint8_t c = 0; c < n_channels; c++) {
+            if (conversions[c] != sim_models[c].value) {
+                fprintf(stderr, "  Read %u channel %u was %d, expected %d\n", read, c, conversions[c],
+                        sim_models[c].value);
+                n_errors++;
+            }
+            if (SIM_WAIT_PIO != wait && 27 != sim_models[c].n_pulses) {
+                fprintf(stderr, "  Read %u channel %u took %u pulses, expected 27\n", read, c, sim_models[c].n_pulses);
+                n_errors++;
+            }
+        }
+    }
+
+    // Let the last readout finish, then check the devices ended up where they should
+    vgpio_advance_to_ps(vgpio_now_ps() + VGPIO_PS_PER_MS);
+    for (uint8_t c = 0; c < n_channels; c++) {
+        if (HX710C_MODEL_DIFFERENTIAL_40HZ != sim_models[c].mode) {
+            fprintf(stderr, "  Channel %u is not in 40Hz differential mode\n", c);
+            n_errors++;
+        }
+        if (0 != sim_models[c].n_power_downs) {
+            fprintf(stderr, "  Channel %u powered down %u times\n", c, sim_models[c].n_power_downs);
+            n_errors++;
+        }
+
+        // A readout started before every device was ready clocks the late ones mid conversion
+        if (n_ignored_pulses[c] != sim_models[c].n_ignored_pulses) {
+            fprintf(stderr, "  Channel %u was clocked %u times while converting\n", c,
+                    sim_models[c].n_ignored_pulses - n_ignored_pulses[c]);
+            n_errors++;
+        }
+    }
+
+    // The DRDY interrupt must only fire once per conversion, not on data edges
+    if (use_ready_callback && SIM_N_READS != sim_n_callbacks) {
+        fprintf(stderr, "  Ready callback fired %u times for %u conversions\n", sim_n_callbacks, SIM_N_READS);
+        n_errors++;
+    }
+
+    const sim_timing_report_t timing = sim_check_timing(n_channels);
+    printf("%.0f,%u,%s,%.3f,%.1f,%.1f,%.1f,%.1f,%.1f,%u,%u\n", clk_sys_hz / 1e6, n_channels,
+           sim_wait_names[wait], sim_ps_to_ns(bus_time_ps / SIM_N_READS) / 1000.0,
+           sim_ps_to_ns(timing.t1_min_ps), sim_ps_to_ns(timing.t2_min_ps), sim_ps_to_ns(timing.t3_min_ps),
+           sim_ps_to_ns(timing.t3_max_ps), sim_ps_to_ns(timing.t4_min_ps), timing.n_violations, n_errors);
+
+    return n_errors + timing.n_violations;
+}
+
+int main(void) {
+    const uint32_t clocks_hz[] = {48000000, 125000000, 133000000, 200000000, 250000000};
+    const uint8_t channel_counts[] = {1, 2, 4, 8, 16};
+
+    uint32_t n_failures = 0;
+    printf("clk_sys_mhz,channels,wait,bus_time_per_read_us,t1_min_ns,t2_min_ns,t3_min_ns,t3_max_ns,t4_min_ns,"
+           "timing_violations,errors\n");
+    for (size_t clock = 0; clock < sizeof(clocks_hz) / sizeof(clocks_hz[0]); clock++) {
+        for (size_t channels = 0; channels < sizeof(channel_counts) / sizeof(channel_counts[0]); channels++) {
+            n_failures += sim_run(clocks_hz[clock], channel_counts[channels], SIM_WAIT_POLL);
+        }
+    }
+    n_failures += sim_run(125000000, 2, SIM_WAIT_DRDY_IRQ);
+
+    // The PIO program waits for at most four devices, and runs off its own clock
+    for (uint8_t n_channels = 1; n_channels <= 4; n_channels++) {
+        n_failures += sim_run(125000000, n_channels, SIM_WAIT_PIO);
+    }
+
+    return 0 == n_failures ? EXIT_SUCCESS : EXIT_FAILURE;
+}
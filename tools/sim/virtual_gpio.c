@@ -0,0 +1,281 @@
+#include "virtual_gpio.h"
+
+#include <hardware/clocks.h>
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/tank_assert.h"
+
+// How often idle time is checked for input edges
+#define VGPIO_IDLE_STEP_PS VGPIO_PS_PER_US
+
+#define VGPIO_MAX_PERIPHERALS 4
+
+static struct {
+    uint32_t clk_sys_hz;
+    uint64_t now_ps;
+
+    bool outputs[VGPIO_N_PINS];
+    bool directions[VGPIO_N_PINS];
+    bool last_input_levels[VGPIO_N_PINS];
+    vgpio_device_t* devices[VGPIO_N_PINS];
+    vgpio_peripheral_t* peripherals[VGPIO_MAX_PERIPHERALS];
+    uint8_t n_peripherals;
+
+    // Interrupts
+    bool bank_irq_enabled;
+    uint32_t irq_enabled_events[VGPIO_N_PINS];
+    uint32_t irq_pending_events[VGPIO_N_PINS];
+    irq_handler_t irq_handler;
+    bool in_irq;
+
+    // Event log
+    vgpio_event_t* events;
+    size_t n_events;
+    size_t events_capacity;
+    uint64_t next_sequence;
+    bool events_sorted;
+} vgpio;
+
+static void vgpio_log(vgpio_event_kind_t kind, uint8_t pin, bool level, uint64_t time_ps) {
+    if (vgpio.n_events == vgpio.events_capacity) {
+        vgpio.events_capacity = vgpio.events_capacity ? vgpio.events_capacity * 2 : 4096;
+        vgpio.events = realloc(vgpio.events, vgpio.events_capacity * sizeof(vgpio_event_t));
+        TANK_ASSERT(NULL != vgpio.events);
+    }
+    vgpio.events[vgpio.n_events++] = (vgpio_event_t){
+        .time_ps = time_ps, .sequence = vgpio.next_sequence++, .kind = kind, .pin = pin, .level = level};
+    vgpio.events_sorted = false;
+}
+
+static bool vgpio_input_level_at(uint8_t pin, uint64_t time_ps, bool sampled) {
+    vgpio_device_t* const device = vgpio.devices[pin];
+    if (NULL == device) {
+        return vgpio.outputs[pin];
+    }
+    return device->level(device->context, time_ps, sampled);
+}
+
+static bool vgpio_input_level(uint8_t pin, bool sampled) {
+    return vgpio_input_level_at(pin, vgpio.now_ps, sampled);
+}
+
+// Sets an output and tells every device about it
+static void vgpio_set_output(uint8_t pin, bool level, uint64_t time_ps) {
+    if (vgpio.outputs[pin] == level) {
+        return;
+    }
+    vgpio.outputs[pin] = level;
+    vgpio_log(VGPIO_EVENT_OUTPUT, pin, level, time_ps);
+    for (uint8_t device_pin = 0; device_pin < VGPIO_N_PINS; device_pin++) {
+        if (NULL != vgpio.devices[device_pin]) {
+            vgpio.devices[device_pin]->on_output(vgpio.devices[device_pin]->context, pin, level, time_ps);
+        }
+    }
+}
+
+// Brings every peripheral and device up to now and raises interrupts for any edges since last time
+static void vgpio_update(void) {
+    // Peripherals first, they drive the devices at times before now
+    for (uint8_t i = 0; i < vgpio.n_peripherals; i++) {
+        vgpio.peripherals[i]->update(vgpio.peripherals[i]->context, vgpio.now_ps);
+    }
+
+    for (uint8_t pin = 0; pin < VGPIO_N_PINS; pin++) {
+        vgpio_device_t* const device = vgpio.devices[pin];
+        if (NULL == device) {
+            continue;
+        }
+        device->update(device->context, vgpio.now_ps);
+
+        const bool level = vgpio_input_level(pin, false);
+        if (level != vgpio.last_input_levels[pin]) {
+            const uint32_t edge = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+            vgpio.irq_pending_events[pin] |= edge & vgpio.irq_enabled_events[pin];
+            vgpio.last_input_levels[pin] = level;
+        }
+    }
+
+    // Deliver interrupts, not nested
+    if (vgpio.in_irq || !vgpio.bank_irq_enabled || NULL == vgpio.irq_handler) {
+        return;
+    }
+    for (uint8_t pin = 0; pin < VGPIO_N_PINS; pin++) {
+        if (0 != vgpio.irq_pending_events[pin]) {
+            vgpio.in_irq = true;
+            vgpio.irq_handler();
+            vgpio.in_irq = false;
+        }
+    }
+}
+
+static void vgpio_advance_cycles(uint32_t cycles) {
+    vgpio.now_ps += (uint64_t)cycles * 1000000000000ull / vgpio.clk_sys_hz;
+    vgpio_update();
+}
+
+void vgpio_reset(uint32_t clk_sys_hz) {
+    // Raw handlers are only ever added once by drivers, so they survive a reset
+    const irq_handler_t irq_handler = vgpio.irq_handler;
+    free(vgpio.events);
+    memset(&vgpio, 0, sizeof(vgpio));
+    vgpio.irq_handler = irq_handler;
+    vgpio.clk_sys_hz = clk_sys_hz;
+    vgpio.events_sorted = true;
+}
+
+void vgpio_attach(vgpio_device_t* device) {
+    TANK_ASSERT(device->pin < VGPIO_N_PINS);
+    vgpio.devices[device->pin] = device;
+    device->update(device->context, vgpio.now_ps);
+    vgpio.last_input_levels[device->pin] = device->level(device->context, vgpio.now_ps, false);
+}
+
+void vgpio_attach_peripheral(vgpio_peripheral_t* peripheral) {
+    TANK_ASSERT(vgpio.n_peripherals < VGPIO_MAX_PERIPHERALS);
+    vgpio.peripherals[vgpio.n_peripherals++] = peripheral;
+}
+
+void vgpio_peripheral_put(uint8_t pin, bool level, uint64_t time_ps) {
+    TANK_ASSERT(pin < VGPIO_N_PINS);
+    vgpio_set_output(pin, level, time_ps);
+}
+
+bool vgpio_peripheral_get(uint8_t pin, uint64_t time_ps, bool sampled) {
+    TANK_ASSERT(pin < VGPIO_N_PINS);
+    if (sampled) {
+        vgpio_log(VGPIO_EVENT_SAMPLE, pin, false, time_ps);
+    }
+    return vgpio_input_level_at(pin, time_ps, sampled);
+}
+
+uint64_t vgpio_now_ps(void) {
+    return vgpio.now_ps;
+}
+
+void vgpio_advance_to_ps(uint64_t time_ps) {
+    while (vgpio.now_ps < time_ps) {
+        const uint64_t step = time_ps - vgpio.now_ps;
+        vgpio.now_ps += step < VGPIO_IDLE_STEP_PS ? step : VGPIO_IDLE_STEP_PS;
+        vgpio_update();
+    }
+}
+
+void vgpio_log_input(uint8_t pin, bool level, uint64_t time_ps) {
+    vgpio_log(VGPIO_EVENT_INPUT, pin, level, time_ps);
+}
+
+static int vgpio_compare_events(const void* a, const void* b) {
+    const vgpio_event_t* const event_a = a;
+    const vgpio_event_t* const event_b = b;
+    if (event_a->time_ps != event_b->time_ps) {
+        return event_a->time_ps < event_b->time_ps ? -1 : 1;
+    }
+    return event_a->sequence < event_b->sequence ? -1 : 1;
+}
+
+const vgpio_event_t* vgpio_events(size_t* n_events) {
+    // Models log input changes lazily, with times that may be in the past
+    if (!vgpio.events_sorted) {
+        qsort(vgpio.events, vgpio.n_events, sizeof(vgpio_event_t), vgpio_compare_events);
+        vgpio.events_sorted = true;
+    }
+    *n_events = vgpio.n_events;
+    return vgpio.events;
+}
+
+void vgpio_clear_events(void) {
+    vgpio.n_events = 0;
+    vgpio.events_sorted = true;
+}
+
+// =============================================================================
+// SDK stand ins
+// =============================================================================
+
+void vgpio_busy_wait_cycles(uint32_t cycles) {
+    vgpio_advance_cycles(cycles);
+}
+
+uint32_t clock_get_hz(enum clock_index clock) {
+    (void)clock;
+    return vgpio.clk_sys_hz;
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    if (IO_IRQ_BANK0 == num) {
+        vgpio.bank_irq_enabled = enabled;
+    }
+}
+
+void gpio_init(uint gpio) {
+    TANK_ASSERT(gpio < VGPIO_N_PINS);
+    vgpio.directions[gpio] = GPIO_IN;
+    vgpio.outputs[gpio] = false;
+}
+
+void gpio_disable_pulls(uint gpio) {
+    (void)gpio;
+}
+
+void gpio_pull_up(uint gpio) {
+    (void)gpio;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    TANK_ASSERT(gpio < VGPIO_N_PINS);
+    vgpio.directions[gpio] = out;
+}
+
+void gpio_put(uint gpio, bool value) {
+    TANK_ASSERT(gpio < VGPIO_N_PINS);
+    TANK_ASSERT_M(GPIO_OUT == vgpio.directions[gpio], "GPIO %u is not an output", gpio);
+    vgpio_advance_cycles(VGPIO_CYCLES_PER_ACCESS);
+    vgpio_set_output((uint8_t)gpio, value, vgpio.now_ps);
+}
+
+bool gpio_get(uint gpio) {
+    TANK_ASSERT(gpio < VGPIO_N_PINS);
+    vgpio_advance_cycles(VGPIO_CYCLES_PER_ACCESS);
+    vgpio_log(VGPIO_EVENT_SAMPLE, (uint8_t)gpio, false, vgpio.now_ps);
+    return vgpio_input_level((uint8_t)gpio, true);
+}
+
+uint32_t gpio_get_all(void) {
+    vgpio_advance_cycles(VGPIO_CYCLES_PER_ACCESS);
+    vgpio_log(VGPIO_EVENT_SAMPLE, 0, false, vgpio.now_ps);
+    uint32_t levels = 0;
+    for (uint8_t pin = 0; pin < VGPIO_N_PINS; pin++) {
+        levels |= (uint32_t)vgpio_input_level(pin, true) << pin;
+    }
+    return levels;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+    TANK_ASSERT(gpio < VGPIO_N_PINS);
+    // Like the SDK, stale events are cleared first
+    vgpio.irq_pending_events[gpio] &= ~event_mask;
+    if (enabled) {
+        vgpio.irq_enabled_events[gpio] |= event_mask;
+    } else {
+        vgpio.irq_enabled_events[gpio] &= ~event_mask;
+    }
+}
+
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask) {
+    TANK_ASSERT(gpio < VGPIO_N_PINS);
+    vgpio.irq_pending_events[gpio] &= ~event_mask;
+}
+
+uint32_t gpio_get_irq_event_mask(uint gpio) {
+    TANK_ASSERT(gpio < VGPIO_N_PINS);
+    return vgpio.irq_pending_events[gpio];
+}
+
+void gpio_add_raw_irq_handler(uint gpio, irq_handler_t handler) {
+    (void)gpio;
+    TANK_ASSERT_M(NULL == vgpio.irq_handler || handler == vgpio.irq_handler, "Only one raw IRQ handler is simulated");
+    vgpio.irq_handler = handler;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A virtual clock and GPIO bank that stands in for the RP2040 when running
+// bit-banged drivers on a host, see tools/stubs/hardware/gpio.h.
+//
+// Time only moves when the driver busy waits, touches a pin, or the caller
+// idles with vgpio_advance_to_ps(). Every pin access costs
+// VGPIO_CYCLES_PER_ACCESS cycles of clk_sys. Times are kept in picoseconds so
+// cycle times at any clock speed are exact enough.
+
+#define VGPIO_N_PINS 30
+#define VGPIO_CYCLES_PER_ACCESS 2
+#define VGPIO_PS_PER_NS 1000ull
+#define VGPIO_PS_PER_US 1000000ull
+#define VGPIO_PS_PER_MS 1000000000ull
+
+typedef enum vgpio_event_kind {
+    VGPIO_EVENT_OUTPUT,  // The driver changed an output
+    VGPIO_EVENT_INPUT,   // A device model changed an input
+    VGPIO_EVENT_SAMPLE,  // The driver read the inputs
+} vgpio_event_kind_t;
+
+typedef struct vgpio_event {
+    uint64_t time_ps;
+    uint64_t sequence;  // Orders events logged at the same time
+    vgpio_event_kind_t kind;
+    uint8_t pin;  // Not used by samples
+    bool level;   // Not used by samples
+} vgpio_event_t;
+
+// A device model driving one input pin.
+typedef struct vgpio_device {
+    uint8_t pin;
+    void* context;
+
+    // Brings the model up to `now_ps`, logging any input changes with vgpio_log_input()
+    void (*update)(void* context, uint64_t now_ps);
+
+    // Returns the level of the input pin at `now_ps`, `sampled` is true if the driver is reading it
+    bool (*level)(void* context, uint64_t now_ps, bool sampled);
+
+    // Called whenever the driver changes an output
+    void (*on_output)(void* context, uint8_t pin, bool level, uint64_t now_ps);
+} vgpio_device_t;
+
+// A peripheral that runs off its own clock alongside the driver, like a PIO
+// state machine, and drives and samples pins with vgpio_peripheral_put() and
+// vgpio_peripheral_get().
+typedef struct vgpio_peripheral {
+    void* context;
+
+    // Runs the peripheral up to `now_ps`, called before any device is brought up to it
+    void (*update)(void* context, uint64_t now_ps);
+} vgpio_peripheral_t;
+
+// Clears all pins, devices, peripherals, events and the clock.
+void vgpio_reset(uint32_t clk_sys_hz);
+
+// Attaches a device model to its pin. The device must outlive the next reset.
+void vgpio_attach(vgpio_device_t* device);
+
+// Attaches a peripheral. The peripheral must outlive the next reset.
+void vgpio_attach_peripheral(vgpio_peripheral_t* peripheral);
+
+// Drives `pin` from a peripheral at `time_ps`, which must not be before the
+// peripheral's last update.
+void vgpio_peripheral_put(uint8_t pin, bool level, uint64_t time_ps);
+
+// Reads `pin` from a peripheral at `time_ps`, logging a sample if `sampled`.
+bool vgpio_peripheral_get(uint8_t pin, uint64_t time_ps, bool sampled);
+
+uint64_t vgpio_now_ps(void);
+
+// Idles until `time_ps`, delivering GPIO interrupts as inputs change.
+void vgpio_advance_to_ps(uint64_t time_ps);
+
+// Logs a change of an input pin, for device models.
+void vgpio_log_input(uint8_t pin, bool level, uint64_t time_ps);
+
+// Returns every event since the last reset or clear, in time order.
+const vgpio_event_t* vgpio_events(size_t* n_events);
+
+void vgpio_clear_events(void);
@@ -0,0 +1,359 @@
+#include "virtual_pio.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/tank_assert.h"
+
+#define VPIO_MAX_LINE 256
+#define VPIO_MAX_TOKENS 16
+#define VPIO_MAX_LABELS VPIO_MAX_INSTRUCTIONS
+
+typedef struct vpio_label {
+    char name[VPIO_MAX_NAME];
+    uint8_t address;
+} vpio_label_t;
+
+// Labels and the jumps that still need them, while assembling
+typedef struct vpio_assembler {
+    vpio_label_t labels[VPIO_MAX_LABELS];
+    uint8_t n_labels;
+    char jump_targets[VPIO_MAX_INSTRUCTIONS][VPIO_MAX_NAME];
+} vpio_assembler_t;
+
+static void vpio_add_symbol(vpio_program_t* program, const char* name, uint32_t value) {
+    TANK_ASSERT(program->n_symbols < VPIO_MAX_SYMBOLS && strlen(name) < VPIO_MAX_NAME);
+    vpio_symbol_t* const symbol = &program->symbols[program->n_symbols++];
+    strcpy(symbol->name, name);
+    symbol->value = value;
+}
+
+static uint32_t vpio_parse_value(const char* token) {
+    char* end;
+    const unsigned long value = strtoul(token, &end, 0);
+    TANK_ASSERT_M('\0' == *end, "Expected a number, got '%s'", token);
+    return (uint32_t)value;
+}
+
+static vpio_operand_t vpio_parse_operand(const char* token) {
+    static const struct {
+        const char* name;
+        vpio_operand_t operand;
+    } operands[] = {
+        {"pins", VPIO_OPERAND_PINS}, {"pin", VPIO_OPERAND_PINS}, {"gpio", VPIO_OPERAND_GPIO},
+        {"x", VPIO_OPERAND_X},       {"y", VPIO_OPERAND_Y},      {"null", VPIO_OPERAND_NULL},
+        {"!x", VPIO_OPERAND_NOT_X},  {"x--", VPIO_OPERAND_X_DEC}, {"!y", VPIO_OPERAND_NOT_Y},
+        {"y--", VPIO_OPERAND_Y_DEC},
+    };
+    for (size_t i = 0; i < sizeof(operands) / sizeof(operands[0]); i++) {
+        if (0 == strcmp(token, operands[i].name)) {
+            return operands[i].operand;
+        }
+    }
+    TANK_ASSERT_M(false, "Unsupported PIO operand '%s'", token);
+    return VPIO_OPERAND_NONE;
+}
+
+// Splits a line into tokens on whitespace and commas, dropping any comment
+static uint8_t vpio_tokenize(char* line, char* tokens[VPIO_MAX_TOKENS]) {
+    char* const comment = strchr(line, ';');
+    if (NULL != comment) {
+        *comment = '\0';
+    }
+    uint8_t n_tokens = 0;
+    for (char* token = strtok(line, " \t\r\n,"); NULL != token; token = strtok(NULL, " \t\r\n,")) {
+        TANK_ASSERT(n_tokens < VPIO_MAX_TOKENS);
+        tokens[n_tokens++] = token;
+    }
+    return n_tokens;
+}
+
+static void vpio_parse_directive(vpio_program_t* program, char* tokens[], uint8_t n_tokens) {
+    if (0 == strcmp(tokens[0], ".side_set")) {
+        TANK_ASSERT_M(2 == n_tokens, "Optional and pindirs side-set are not supported");
+        program->side_set_bits = (uint8_t)vpio_parse_value(tokens[1]);
+    } else if (0 == strcmp(tokens[0], ".wrap_target")) {
+        program->wrap_target = program->length;
+    } else if (0 == strcmp(tokens[0], ".wrap")) {
+        TANK_ASSERT(program->length > 0);
+        program->wrap = program->length - 1;
+    } else if (0 == strcmp(tokens[0], ".define")) {
+        const bool public = 4 == n_tokens && 0 == strcmp(tokens[1], "public");
+        TANK_ASSERT_M(public || 3 == n_tokens, "Malformed .define");
+        if (public) {
+            vpio_add_symbol(program, tokens[2], vpio_parse_value(tokens[3]));
+        }
+    } else {
+        TANK_ASSERT_M(0 == strcmp(tokens[0], ".program"), "Unsupported PIO directive '%s'", tokens[0]);
+    }
+}
+
+static void vpio_parse_instruction(vpio_program_t* program, vpio_assembler_t* assembler, char* tokens[],
+                                   uint8_t n_tokens) {
+    TANK_ASSERT_M(program->length < VPIO_MAX_INSTRUCTIONS, "PIO program too long");
+    vpio_instruction_t* const instruction = &program->instructions[program->length];
+    memset(instruction, 0, sizeof(vpio_instruction_t));
+
+    // Side-set and delay trail the operands
+    bool has_side = 0 == program->side_set_bits;
+    while (n_tokens > 1) {
+        const char* const last = tokens[n_tokens - 1];
+        if ('[' == last[0]) {
+            instruction->delay = (uint8_t)strtoul(last + 1, NULL, 0);
+            n_tokens--;
+        } else if (n_tokens > 2 && 0 == strcmp(tokens[n_tokens - 2], "side")) {
+            instruction->side = (uint8_t)vpio_parse_value(last);
+            has_side = true;
+            n_tokens -= 2;
+        } else {
+            break;
+        }
+    }
+    TANK_ASSERT_M(has_side, "Side-set is not optional");
+
+    const char* const op = tokens[0];
+    if (0 == strcmp(op, "nop")) {
+        instruction->op = VPIO_OP_NOP;
+    } else if (0 == strcmp(op, "jmp")) {
+        instruction->op = VPIO_OP_JMP;
+        instruction->operand = 3 == n_tokens ? vpio_parse_operand(tokens[1]) : VPIO_OPERAND_NONE;
+        TANK_ASSERT(strlen(tokens[n_tokens - 1]) < VPIO_MAX_NAME);
+        strcpy(assembler->jump_targets[program->length], tokens[n_tokens - 1]);
+    } else if (0 == strcmp(op, "wait")) {
+        TANK_ASSERT_M(4 == n_tokens, "Malformed wait");
+        instruction->op = VPIO_OP_WAIT;
+        instruction->value = vpio_parse_value(tokens[1]);
+        instruction->operand = vpio_parse_operand(tokens[2]);
+        instruction->index = (uint8_t)vpio_parse_value(tokens[3]);
+    } else if (0 == strcmp(op, "in")) {
+        TANK_ASSERT_M(3 == n_tokens, "Malformed in");
+        instruction->op = VPIO_OP_IN;
+        instruction->operand = vpio_parse_operand(tokens[1]);
+        instruction->value = vpio_parse_value(tokens[2]);
+    } else if (0 == strcmp(op, "push")) {
+        instruction->op = VPIO_OP_PUSH;
+        instruction->block = 1 == n_tokens || 0 != strcmp(tokens[n_tokens - 1], "noblock");
+    } else if (0 == strcmp(op, "set")) {
+        TANK_ASSERT_M(3 == n_tokens, "Malformed set");
+        instruction->op = VPIO_OP_SET;
+        instruction->operand = vpio_parse_operand(tokens[1]);
+        instruction->value = vpio_parse_value(tokens[2]);
+    } else {
+        TANK_ASSERT_M(false, "Unsupported PIO instruction '%s'", op);
+    }
+    program->length++;
+}
+
+void vpio_assemble(vpio_program_t* program, const char* path) {
+    memset(program, 0, sizeof(vpio_program_t));
+    vpio_assembler_t assembler = {0};
+
+    FILE* const file = fopen(path, "r");
+    TANK_ASSERT_M(NULL != file, "Could not open %s", path);
+    char line[VPIO_MAX_LINE];
+    bool wrap_set = false;
+    while (NULL != fgets(line, sizeof(line), file)) {
+        // The program ends where the C SDK block starts
+        if ('%' == line[0]) {
+            break;
+        }
+        char* tokens[VPIO_MAX_TOKENS];
+        const uint8_t n_tokens = vpio_tokenize(line, tokens);
+        if (0 == n_tokens) {
+            continue;
+        }
+
+        // Labels
+        const bool public = 2 == n_tokens && 0 == strcmp(tokens[0], "public");
+        char* const name = tokens[public ? 1 : 0];
+        const size_t name_length = strlen(name);
+        if (':' == name[name_length - 1] && (public || 1 == n_tokens)) {
+            name[name_length - 1] = '\0';
+            TANK_ASSERT(assembler.n_labels < VPIO_MAX_LABELS && name_length <= VPIO_MAX_NAME);
+            strcpy(assembler.labels[assembler.n_labels].name, name);
+            assembler.labels[assembler.n_labels++].address = program->length;
+            if (public) {
+                vpio_add_symbol(program, name, program->length);
+            }
+            continue;
+        }
+
+        if ('.' == tokens[0][0]) {
+            wrap_set |= 0 == strcmp(tokens[0], ".wrap");
+            vpio_parse_directive(program, tokens, n_tokens);
+        } else {
+            vpio_parse_instruction(program, &assembler, tokens, n_tokens);
+        }
+    }
+    fclose(file);
+    TANK_ASSERT_M(program->length > 0, "No PIO program in %s", path);
+    if (!wrap_set) {
+        program->wrap = program->length - 1;
+    }
+
+    // Resolve jumps
+    for (uint8_t i = 0; i < program->length; i++) {
+        if (VPIO_OP_JMP != program->instructions[i].op) {
+            continue;
+        }
+        bool found = false;
+        for (uint8_t label = 0; label < assembler.n_labels && !found; label++) {
+            if (0 == strcmp(assembler.labels[label].name, assembler.jump_targets[i])) {
+                program->instructions[i].value = assembler.labels[label].address;
+                found = true;
+            }
+        }
+        TANK_ASSERT_M(found, "Unknown PIO label '%s'", assembler.jump_targets[i]);
+    }
+}
+
+uint32_t vpio_symbol(const vpio_program_t* program, const char* name) {
+    for (uint8_t i = 0; i < program->n_symbols; i++) {
+        if (0 == strcmp(program->symbols[i].name, name)) {
+            return program->symbols[i].value;
+        }
+    }
+    TANK_ASSERT_M(false, "PIO program has no public symbol '%s'", name);
+    return 0;
+}
+
+// Reads the 32 pins from `base`, wrapping like the IN mapping does, pins past the bank read low
+static uint32_t vpio_read_pins(uint8_t base, uint64_t time_ps) {
+    uint32_t levels = 0;
+    for (uint8_t i = 0; i < 32; i++) {
+        const uint8_t pin = (base + i) % 32;
+        if (pin < VGPIO_N_PINS && vgpio_peripheral_get(pin, time_ps, 0 == i)) {
+            levels |= 1u << i;
+        }
+    }
+    return levels;
+}
+
+// Runs one cycle at `time_ps`
+static void vpio_sm_cycle(vpio_sm_t* sm, uint64_t time_ps) {
+    if (sm->delay > 0) {
+        sm->delay--;
+        return;
+    }
+
+    const vpio_program_t* const program = sm->program;
+    const vpio_instruction_t* const instruction = &program->instructions[sm->pc];
+
+    // Side-set is asserted on the first cycle of an instruction, even if it stalls
+    for (uint8_t bit = 0; bit < program->side_set_bits; bit++) {
+        vgpio_peripheral_put(sm->side_set_base_pin + bit, (instruction->side >> bit) & 0x1, time_ps);
+    }
+
+    uint8_t next_pc = sm->pc == sm->wrap ? sm->wrap_target : sm->pc + 1;
+    switch (instruction->op) {
+        case VPIO_OP_NOP:
+            break;
+
+        case VPIO_OP_JMP: {
+            bool jump;
+            switch (instruction->operand) {
+                case VPIO_OPERAND_NOT_X:
+                    jump = 0 == sm->x;
+                    break;
+                case VPIO_OPERAND_X_DEC:
+                    jump = 0 != sm->x--;
+                    break;
+                case VPIO_OPERAND_NOT_Y:
+                    jump = 0 == sm->y;
+                    break;
+                case VPIO_OPERAND_Y_DEC:
+                    jump = 0 != sm->y--;
+                    break;
+                default:
+                    jump = true;
+                    break;
+            }
+            next_pc = jump ? (uint8_t)instruction->value : next_pc;
+            break;
+        }
+
+        case VPIO_OP_WAIT: {
+            TANK_ASSERT_M(VPIO_OPERAND_PINS == instruction->operand || VPIO_OPERAND_GPIO == instruction->operand,
+                          "Only pin and gpio waits are supported");
+            const uint8_t pin = VPIO_OPERAND_PINS == instruction->operand
+                                    ? (sm->in_base_pin + instruction->index) % 32
+                                    : instruction->index;
+            const bool level = pin < VGPIO_N_PINS && vgpio_peripheral_get(pin, time_ps, false);
+            if (level != (0 != instruction->value)) {
+                return;  // Stall, the instruction runs again next cycle
+            }
+            break;
+        }
+
+        case VPIO_OP_IN: {
+            const uint32_t bits = 0 == instruction->value ? 32 : instruction->value;
+            uint32_t data;
+            switch (instruction->operand) {
+                case VPIO_OPERAND_PINS:
+                    data = vpio_read_pins(sm->in_base_pin, time_ps);
+                    break;
+                case VPIO_OPERAND_X:
+                    data = sm->x;
+                    break;
+                case VPIO_OPERAND_Y:
+                    data = sm->y;
+                    break;
+                case VPIO_OPERAND_NULL:
+                    data = 0;
+                    break;
+                default:
+                    TANK_ASSERT_M(false, "Unsupported IN source");
+                    return;
+            }
+            const uint32_t mask = 32 == bits ? 0xFFFFFFFF : (1u << bits) - 1;
+            sm->isr = 32 == bits ? data : (sm->isr << bits) | (data & mask);
+            break;
+        }
+
+        case VPIO_OP_PUSH:
+            sm->push(sm->push_context, sm->isr);
+            sm->isr = 0;
+            break;
+
+        case VPIO_OP_SET:
+            if (VPIO_OPERAND_X == instruction->operand) {
+                sm->x = instruction->value;
+            } else {
+                TANK_ASSERT_M(VPIO_OPERAND_Y == instruction->operand, "Only SET to x and y is supported");
+                sm->y = instruction->value;
+            }
+            break;
+    }
+
+    sm->pc = next_pc;
+    sm->delay = instruction->delay;
+}
+
+static void vpio_sm_update(void* context, uint64_t now_ps) {
+    vpio_sm_t* const sm = context;
+    while (sm->next_cycle_ps <= now_ps) {
+        vpio_sm_cycle(sm, sm->next_cycle_ps);
+        sm->next_cycle_ps += sm->cycle_ps;
+    }
+}
+
+void vpio_sm_start(vpio_sm_t* sm, const vpio_program_t* program, uint8_t entry, uint8_t wrap_target, uint8_t wrap,
+                   uint8_t in_base_pin, uint8_t side_set_base_pin, uint32_t cycle_hz,
+                   void (*push)(void* context, uint32_t word), void* push_context) {
+    TANK_ASSERT(entry < program->length && wrap_target < program->length && wrap < program->length);
+    memset(sm, 0, sizeof(vpio_sm_t));
+    sm->program = program;
+    sm->wrap_target = wrap_target;
+    sm->wrap = wrap;
+    sm->in_base_pin = in_base_pin;
+    sm->side_set_base_pin = side_set_base_pin;
+    sm->cycle_ps = 1000000000000ull / cycle_hz;
+    sm->push = push;
+    sm->push_context = push_context;
+    sm->pc = entry;
+    sm->next_cycle_ps = vgpio_now_ps();
+
+    sm->peripheral = (vgpio_peripheral_t){.context = sm, .update = vpio_sm_update};
+    vgpio_attach_peripheral(&sm->peripheral);
+}
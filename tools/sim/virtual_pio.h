@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "virtual_gpio.h"
+
+// A PIO state machine on the virtual GPIO bank, running a program assembled
+// from its .pio source so the simulators exercise the same program as the
+// firmware.
+//
+// Only the subset of pioasm the firmware's programs use is understood: the
+// .side_set, .wrap_target, .wrap and .define directives, public labels, and
+// the wait, set, in, push, jmp and nop instructions with side-set and delay.
+// Anything else fails an assertion. Input synchronisers are not modelled, IN
+// and WAIT see a pin the cycle it changes.
+
+#define VPIO_MAX_INSTRUCTIONS 32
+#define VPIO_MAX_SYMBOLS 16
+#define VPIO_MAX_NAME 32
+
+typedef enum vpio_op {
+    VPIO_OP_NOP,
+    VPIO_OP_JMP,
+    VPIO_OP_WAIT,
+    VPIO_OP_IN,
+    VPIO_OP_PUSH,
+    VPIO_OP_SET,
+} vpio_op_t;
+
+typedef enum vpio_operand {
+    VPIO_OPERAND_NONE,
+    VPIO_OPERAND_PINS,
+    VPIO_OPERAND_GPIO,
+    VPIO_OPERAND_X,
+    VPIO_OPERAND_Y,
+    VPIO_OPERAND_NULL,
+    VPIO_OPERAND_NOT_X,  // Jump conditions
+    VPIO_OPERAND_X_DEC,
+    VPIO_OPERAND_NOT_Y,
+    VPIO_OPERAND_Y_DEC,
+} vpio_operand_t;
+
+typedef struct vpio_instruction {
+    vpio_op_t op;
+    vpio_operand_t operand;
+    uint32_t value;  // Jump target, wait polarity, set value or bit count
+    uint8_t index;   // Wait pin
+    bool block;      // Push
+    uint8_t side;
+    uint8_t delay;
+} vpio_instruction_t;
+
+typedef struct vpio_symbol {
+    char name[VPIO_MAX_NAME];
+    uint32_t value;
+} vpio_symbol_t;
+
+typedef struct vpio_program {
+    vpio_instruction_t instructions[VPIO_MAX_INSTRUCTIONS];
+    uint8_t length;
+    uint8_t side_set_bits;
+    uint8_t wrap_target;
+    uint8_t wrap;
+
+    // .define public values and public labels
+    vpio_symbol_t symbols[VPIO_MAX_SYMBOLS];
+    uint8_t n_symbols;
+} vpio_program_t;
+
+typedef struct vpio_sm {
+    vgpio_peripheral_t peripheral;
+    const vpio_program_t* program;
+
+    // Configuration, as set by the program's init function on target
+    uint8_t wrap_target;
+    uint8_t wrap;
+    uint8_t in_base_pin;
+    uint8_t side_set_base_pin;
+    uint64_t cycle_ps;
+
+    // Called for every word pushed, the RX FIFO is assumed to always be drained in time
+    void (*push)(void* context, uint32_t word);
+    void* push_context;
+
+    // Execution
+    uint64_t next_cycle_ps;
+    uint8_t pc;
+    uint8_t delay;
+    uint32_t x;
+    uint32_t y;
+    uint32_t isr;
+} vpio_sm_t;
+
+// Assembles the first program in the .pio source at `path`.
+void vpio_assemble(vpio_program_t* program, const char* path);
+
+// Returns the value of a public define or label of the program.
+uint32_t vpio_symbol(const vpio_program_t* program, const char* name);
+
+// Starts `sm` running `program` from `entry` with every register cleared, and
+// attaches it to the virtual GPIO bank. Input shifts left without autopush.
+void vpio_sm_start(vpio_sm_t* sm, const vpio_program_t* program, uint8_t entry, uint8_t wrap_target, uint8_t wrap,
+                   uint8_t in_base_pin, uint8_t side_set_base_pin, uint32_t cycle_hz,
+                   void (*push)(void* context, uint32_t word), void* push_context);
@@ -0,0 +1,32 @@
+#pragma once
+
+// Host stand in for the pico SDK GPIO API, backed by the virtual GPIO layer in
+// tools/sim/virtual_gpio.c.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hardware/irq.h"
+
+#define GPIO_OUT true
+#define GPIO_IN false
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+void gpio_init(uint gpio);
+void gpio_disable_pulls(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+uint32_t gpio_get_all(void);
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled);
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask);
+uint32_t gpio_get_irq_event_mask(uint gpio);
+void gpio_add_raw_irq_handler(uint gpio, irq_handler_t handler);
@@ -0,0 +1,14 @@
+#pragma once
+
+// Host stand in for the pico SDK IRQ API.
+
+#include <stdbool.h>
+
+typedef unsigned int uint;
+
+#define IO_IRQ_BANK0 13
+#define DMA_IRQ_0 11
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_enabled(uint num, bool enabled);
@@ -0,0 +1,10 @@
+#pragma once
+
+// Host stand in for the pico SDK PIO API. Only the type is needed so driver
+// headers compile, the simulators run PIO programs with tools/sim/virtual_pio.h.
+
+typedef struct pio_hw pio_hw_t;
+typedef pio_hw_t* PIO;
+
+#define pio0 ((PIO)0)
+#define pio1 ((PIO)0)
@@ -0,0 +1,14 @@
+#pragma once
+
+// Host stand in for the pico SDK platform API. Busy waits advance the virtual
+// clock instead of spinning.
+
+#include <stdint.h>
+
+void vgpio_busy_wait_cycles(uint32_t cycles);
+
+static inline void busy_wait_at_least_cycles(uint32_t minimum_cycles) {
+    vgpio_busy_wait_cycles(minimum_cycles);
+}
+
+#define __compiler_memory_barrier() __asm__ volatile("" : : : "memory")
@@ -0,0 +1,5 @@
+#pragma once
+
+// Host stand in for the pico SDK time API.
+
+#include <stdint.h>
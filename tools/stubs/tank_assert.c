@@ -0,0 +1,34 @@
+#include "util/tank_assert.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Host version of util/tank_assert.c, aborts instead of halting the scheduler.
+
+void _tank_assert(int assertion, const char* assertion_src, const char* file, const char* function, unsigned int line) {
+    if (0 == assertion) {
+        fprintf(stderr, "ASSERTION FAILED:\n");
+        fprintf(stderr, "  Assertion: %s\n", assertion_src);
+        fprintf(stderr, "  Location: %s:%u\n", file, line);
+        fprintf(stderr, "  Function: %s\n", function);
+        abort();
+    }
+}
+
+void _tank_assert_m(int assertion, const char* assertion_src, const char* file, const char* function, unsigned int line,
+                    const char* fmt, ...) {
+    if (0 == assertion) {
+        va_list args;
+        va_start(args, fmt);
+        fprintf(stderr, "ASSERTION FAILED:\n");
+        fprintf(stderr, "  Assertion: %s\n", assertion_src);
+        fprintf(stderr, "  Message: ");
+        vfprintf(stderr, fmt, args);
+        fprintf(stderr, "\n");
+        fprintf(stderr, "  Location: %s:%u\n", file, line);
+        fprintf(stderr, "  Function: %s\n", function);
+        va_end(args);
+        abort();
+    }
+}
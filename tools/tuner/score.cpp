@@ -0,0 +1,127 @@
+#include "score.hpp"
+
+#include "control/control_pipeline.h"
+
+namespace {
+
+uint64_t score_chatter(const std::vector<uint32_t>& timestamp_us, const std::vector<q16_t>& duty, uint32_t chatter_us) {
+    uint64_t chatter = 0;
+    bool pressed = duty[0] > Q16_ZERO;
+    uint32_t pressed_since_us = timestamp_us[0];
+    bool first_state = true;  // Started before the recording, its length is unknown
+    for (size_t i = 1; i < duty.size(); i++) {
+        const bool now_pressed = duty[i] > Q16_ZERO;
+        if (now_pressed == pressed) {
+            continue;
+        }
+        if (!first_state && timestamp_us[i] - pressed_since_us < chatter_us) {
+            chatter++;
+        }
+        pressed = now_pressed;
+        pressed_since_us = timestamp_us[i];
+        first_state = false;
+    }
+    return chatter;
+}
+
+void score_reactions(const std::vector<uint32_t>& timestamp_us,
+                     const std::vector<q16_t>& report,
+                     const std::vector<q16_t>& duty,
+                     const tuner_score_config& config,
+                     tuner_metrics& metrics) {
+    // An input only counts once it has been seen at rest, and once per rise
+    bool armed = false;
+    size_t last_rest = 0;
+    for (size_t i = 0; i < report.size(); i++) {
+        if (report[i] <= config.rest_level) {
+            // Pressed at rest, counted until the next sample
+            if (i + 1 < report.size()) {
+                const uint32_t period_us = timestamp_us[i + 1] - timestamp_us[i];
+                metrics.rest_us += period_us;
+                metrics.false_us += duty[i] > Q16_ZERO ? period_us : 0;
+            }
+            armed = true;
+            last_rest = i;
+            continue;
+        }
+        if (!armed || report[i] < config.intent_level) {
+            continue;
+        }
+        armed = false;
+
+        // First press from leaving rest until the input returns to rest
+        const size_t moved = last_rest + 1;
+        size_t pressed = moved;
+        while (pressed < report.size() && duty[pressed] <= Q16_ZERO &&
+               !(pressed > i && report[pressed] <= config.rest_level)) {
+            pressed++;
+        }
+        if (pressed < report.size() && duty[pressed] > Q16_ZERO) {
+            metrics.reactions++;
+            metrics.delay_us += timestamp_us[pressed] - timestamp_us[moved];
+        } else {
+            metrics.misses++;
+        }
+    }
+}
+
+}  // namespace
+
+double tuner_metrics::chatter_per_minute() const {
+    return 0 == duration_us ? 0.0 : static_cast<double>(chatter) * 60e6 / static_cast<double>(duration_us);
+}
+
+double tuner_metrics::false_percent() const {
+    return 0 == rest_us ? 0.0 : static_cast<double>(false_us) * 100.0 / static_cast<double>(rest_us);
+}
+
+double tuner_metrics::mean_delay_ms() const {
+    return 0 == reactions ? 0.0 : static_cast<double>(delay_us) / 1e3 / static_cast<double>(reactions);
+}
+
+tuner_metrics tuner_score(const std::vector<tuner_session>& sessions,
+                          const control_settings_t& settings,
+                          const control_raw_report_t& calibration_min,
+                          const control_raw_report_t& calibration_max,
+                          const tuner_score_config& config) {
+    control_transform_t transform;
+    control_transform_build(&transform, &settings, &calibration_min, &calibration_max);
+
+    // Reused between candidates on the same worker
+    thread_local std::vector<q16_t> forward;
+    thread_local std::vector<q16_t> left;
+    thread_local std::vector<q16_t> right;
+    thread_local std::vector<q16_t> hand_brake;
+
+    tuner_metrics metrics = {};
+    for (const tuner_session& session : sessions) {
+        const size_t n = session.predicted.size();
+        forward.resize(n);
+        left.resize(n);
+        right.resize(n);
+        hand_brake.resize(n);
+
+        // The same pipeline the input task runs
+        for (size_t i = 0; i < n; i++) {
+            const keyboard_output_t output = control_pipeline_run(&transform, &session.predicted[i]);
+            forward[i] = output.forward_duty_cycle;
+            left[i] = output.left_duty_cycle;
+            right[i] = output.right_duty_cycle;
+            hand_brake[i] = output.hand_brake_duty_cycle;
+        }
+
+        for (const std::vector<q16_t>* duty : {&forward, &left, &right, &hand_brake}) {
+            metrics.chatter += score_chatter(session.timestamp_us, *duty, config.chatter_us);
+        }
+        score_reactions(session.timestamp_us, session.accelerator, forward, config, metrics);
+        score_reactions(session.timestamp_us, session.left_tiller, left, config, metrics);
+        score_reactions(session.timestamp_us, session.right_tiller, right, config, metrics);
+        metrics.duration_us += session.timestamp_us.back() - session.timestamp_us.front();
+    }
+
+    metrics.score = config.chatter_weight * metrics.chatter_per_minute() +
+                    config.false_weight * metrics.false_percent() +
+                    config.delay_weight * metrics.mean_delay_ms() +
+                    config.miss_weight * static_cast<double>(metrics.misses);
+    return metrics;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "session.hpp"
+
+// What the score rewards and punishes, set from the command line
+struct tuner_score_config {
+    q16_t rest_level;         // Reports at or below this are a sensor left alone
+    q16_t intent_level;       // Reports crossing this are a deliberate input that must reach the keyboard
+    uint32_t chatter_us;      // A key state held for less than this is chatter
+    double chatter_weight;    // Score per chattered key state per minute
+    double false_weight;      // Score per percent of rest time with the key pressed
+    double delay_weight;      // Score per millisecond of mean reaction delay
+    double miss_weight;       // Score per deliberate input that never reached the keyboard
+};
+
+struct tuner_metrics {
+    uint64_t chatter;       // Key states shorter than chatter_us, over every key
+    uint64_t rest_us;       // Time inputs spent at rest, over every input with a key
+    uint64_t false_us;      // Time keys were pressed while their input was at rest
+    uint64_t reactions;     // Deliberate inputs that reached the keyboard
+    uint64_t misses;        // Deliberate inputs that did not
+    uint64_t delay_us;      // Sum of reaction delays
+    uint64_t duration_us;   // Session time covered
+    double score;           // Lower is better
+
+    double chatter_per_minute() const;
+    double mean_delay_ms() const;
+    double false_percent() const;
+};
+
+// Runs every prepared session through the control pipeline with `settings` and
+// scores the key outputs.
+// A reaction delay runs from an input leaving rest to its key first being
+// pressed, for each rise of the report through the intent level.
+tuner_metrics tuner_score(const std::vector<tuner_session>& sessions,
+                          const control_settings_t& settings,
+                          const control_raw_report_t& calibration_min,
+                          const control_raw_report_t& calibration_max,
+                          const tuner_score_config& config);
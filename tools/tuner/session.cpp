@@ -0,0 +1,198 @@
+#include "session.hpp"
+
+#include <charconv>
+#include <fstream>
+#include <string_view>
+
+extern "C" {
+#include "control/tiller_predictor.h"
+#include "util/filter.h"
+#include "util/quantile.h"
+}
+
+namespace {
+
+constexpr size_t session_columns = 7;
+
+// Robust calibration percentiles, matching the input task
+constexpr uint32_t session_calibration_low_q16 = 655;     // 1%
+constexpr uint32_t session_calibration_high_q16 = 64881;  // 99%
+
+template <typename T>
+bool session_parse(std::string_view field, T& value) {
+    while (!field.empty() && (' ' == field.front())) {
+        field.remove_prefix(1);
+    }
+    while (!field.empty() && (' ' == field.back() || '\r' == field.back())) {
+        field.remove_suffix(1);
+    }
+    const auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+    return std::errc() == error && end == field.data() + field.size();
+}
+
+struct session_range {
+    quantile_t low;
+    quantile_t high;
+
+    session_range() {
+        quantile_init(&low, session_calibration_low_q16);
+        quantile_init(&high, session_calibration_high_q16);
+    }
+
+    void add(int32_t sample) {
+        quantile_add(&low, sample);
+        quantile_add(&high, sample);
+    }
+};
+
+}  // namespace
+
+bool tuner_session_load(const std::string& path, tuner_session& session, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    session = {};
+    session.name = path;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (1 == line_number || line.empty() || '#' == line.front()) {
+            continue;  // Header or comment
+        }
+
+        std::string_view fields[session_columns];
+        size_t n_fields = 0;
+        std::string_view rest = line;
+        while (n_fields < session_columns) {
+            const size_t comma = rest.find(',');
+            fields[n_fields++] = rest.substr(0, comma);
+            if (std::string_view::npos == comma) {
+                rest = {};
+                break;
+            }
+            rest.remove_prefix(comma + 1);
+        }
+
+        uint32_t timestamp_us = 0;
+        uint32_t tiller_timestamp_us = 0;
+        control_raw_report_t raw = {};
+        const bool parsed = session_columns == n_fields && rest.empty() &&
+                            session_parse(fields[0], timestamp_us) && session_parse(fields[1], raw.accelerator) &&
+                            session_parse(fields[2], raw.brake) && session_parse(fields[3], raw.clutch) &&
+                            session_parse(fields[4], raw.left_tiller) && session_parse(fields[5], raw.right_tiller) &&
+                            session_parse(fields[6], tiller_timestamp_us);
+        if (!parsed) {
+            error = path + ":" + std::to_string(line_number) + ": expected " + std::to_string(session_columns) +
+                    " integer columns";
+            return false;
+        }
+        if (!session.timestamp_us.empty() && timestamp_us < session.timestamp_us.back()) {
+            error = path + ":" + std::to_string(line_number) + ": timestamps must not go backwards";
+            return false;
+        }
+
+        session.timestamp_us.push_back(timestamp_us);
+        session.raw.push_back(raw);
+        session.tiller_timestamp_us.push_back(tiller_timestamp_us);
+    }
+
+    if (session.raw.empty()) {
+        error = path + ": no samples";
+        return false;
+    }
+    return true;
+}
+
+void tuner_sessions_calibrate(const std::vector<tuner_session>& sessions,
+                              control_raw_report_t& calibration_min,
+                              control_raw_report_t& calibration_max) {
+    session_range accelerator;
+    session_range brake;
+    session_range clutch;
+    session_range left_tiller;
+    session_range right_tiller;
+    for (const tuner_session& session : sessions) {
+        for (size_t i = 0; i < session.raw.size(); i++) {
+            const control_raw_report_t& raw = session.raw[i];
+            accelerator.add(raw.accelerator);
+            brake.add(raw.brake);
+            clutch.add(raw.clutch);
+
+            // Tillers once per conversion
+            if (0 == i || session.tiller_timestamp_us[i] != session.tiller_timestamp_us[i - 1]) {
+                left_tiller.add(raw.left_tiller);
+                right_tiller.add(raw.right_tiller);
+            }
+        }
+    }
+
+    calibration_min.accelerator = static_cast<int16_t>(quantile_get(&accelerator.low));
+    calibration_min.brake = static_cast<int16_t>(quantile_get(&brake.low));
+    calibration_min.clutch = static_cast<int16_t>(quantile_get(&clutch.low));
+    calibration_min.left_tiller = quantile_get(&left_tiller.low);
+    calibration_min.right_tiller = quantile_get(&right_tiller.low);
+    calibration_max.accelerator = static_cast<int16_t>(quantile_get(&accelerator.high));
+    calibration_max.brake = static_cast<int16_t>(quantile_get(&brake.high));
+    calibration_max.clutch = static_cast<int16_t>(quantile_get(&clutch.high));
+    calibration_max.left_tiller = quantile_get(&left_tiller.high);
+    calibration_max.right_tiller = quantile_get(&right_tiller.high);
+}
+
+void tuner_session_prepare(tuner_session& session,
+                           const control_settings_t& settings,
+                           const control_raw_report_t& calibration_min,
+                           const control_raw_report_t& calibration_max) {
+    filter_t accelerator_filter;
+    filter_t left_tiller_filter;
+    filter_t right_tiller_filter;
+    filter_init(&accelerator_filter, &settings.accelerator_filter);
+    filter_init(&left_tiller_filter, &settings.left_tiller_filter);
+    filter_init(&right_tiller_filter, &settings.right_tiller_filter);
+    tiller_predictor_t left_tiller_predictor;
+    tiller_predictor_t right_tiller_predictor;
+    tiller_predictor_init(&left_tiller_predictor);
+    tiller_predictor_init(&right_tiller_predictor);
+
+    const size_t n = session.raw.size();
+    std::vector<int16_t> accelerator(n);
+    std::vector<int32_t> left_tiller(n);
+    std::vector<int32_t> right_tiller(n);
+    session.predicted.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        accelerator[i] = static_cast<int16_t>(filter_apply(&accelerator_filter, session.raw[i].accelerator));
+        if (0 == i || session.tiller_timestamp_us[i] != session.tiller_timestamp_us[i - 1]) {
+            left_tiller[i] = filter_apply(&left_tiller_filter, session.raw[i].left_tiller);
+            right_tiller[i] = filter_apply(&right_tiller_filter, session.raw[i].right_tiller);
+            tiller_predictor_update(&left_tiller_predictor, left_tiller[i], session.tiller_timestamp_us[i]);
+            tiller_predictor_update(&right_tiller_predictor, right_tiller[i], session.tiller_timestamp_us[i]);
+        } else {
+            left_tiller[i] = left_tiller[i - 1];
+            right_tiller[i] = right_tiller[i - 1];
+        }
+
+        // As input_predict_tillers(), at the time the pedals were read
+        control_raw_report_t& predicted = session.predicted[i];
+        predicted = session.raw[i];
+        predicted.accelerator = accelerator[i];
+        predicted.left_tiller = tiller_predictor_estimate(&left_tiller_predictor, session.timestamp_us[i],
+                                                          settings.tiller_prediction_horizon_us);
+        predicted.right_tiller = tiller_predictor_estimate(&right_tiller_predictor, session.timestamp_us[i],
+                                                           settings.tiller_prediction_horizon_us);
+    }
+
+    control_transform_t transform;
+    control_transform_build(&transform, &settings, &calibration_min, &calibration_max);
+    session.accelerator.resize(n);
+    session.left_tiller.resize(n);
+    session.right_tiller.resize(n);
+    const control_raw_batch_t raw = {
+        .accelerator = accelerator.data(), .left_tiller = left_tiller.data(), .right_tiller = right_tiller.data()};
+    const input_report_batch_t reports = {.accelerator = session.accelerator.data(),
+                                          .left_tiller = session.left_tiller.data(),
+                                          .right_tiller = session.right_tiller.data()};
+    input_make_report_batch(&transform, &raw, n, &reports);
+}
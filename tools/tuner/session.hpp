@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "control/control_map.h"
+#include "control/types.h"
+}
+
+// A recorded session of raw sensor values, one row per input task cycle. On
+// disk it is CSV with a header line and the columns
+//   timestamp_us,accelerator,brake,clutch,left_tiller,right_tiller,tiller_timestamp_us
+// where tiller_timestamp_us is when the force sensor conversion in the row was
+// taken, so repeated tiller values are only filtered once like on the rig.
+struct tuner_session {
+    std::string name;
+    std::vector<uint32_t> timestamp_us;
+    std::vector<control_raw_report_t> raw;
+    std::vector<uint32_t> tiller_timestamp_us;
+
+    // Filled by tuner_session_prepare(). The candidates are run from the
+    // predicted raw values, the reports are what the inputs actually did.
+    std::vector<control_raw_report_t> predicted;
+    std::vector<q16_t> accelerator;
+    std::vector<q16_t> left_tiller;
+    std::vector<q16_t> right_tiller;
+};
+
+// Loads a session from `path`. Returns false and sets `error` if it cannot be read.
+bool tuner_session_load(const std::string& path, tuner_session& session, std::string& error);
+
+// Calibrates from the 1st and 99th percentiles of every session, the same as
+// calibrating on the rig while they were recorded
+void tuner_sessions_calibrate(const std::vector<tuner_session>& sessions,
+                              control_raw_report_t& calibration_min,
+                              control_raw_report_t& calibration_max);
+
+// Filters the raw values with the filters in `settings` and predicts the
+// tillers over its horizon, as the input task does before running the control
+// pipeline. Also scales the filtered values into reports. The swept settings
+// all act after this point, so it is done once.
+void tuner_session_prepare(tuner_session& session,
+                           const control_settings_t& settings,
+                           const control_raw_report_t& calibration_min,
+                           const control_raw_report_t& calibration_max);
@@ -0,0 +1,338 @@
+// Sweeps the deadzone, turning and hand brake settings over recorded sessions
+// and ranks them on key chatter and reaction delay. Sessions go through the
+// firmware's own filters, tiller predictor and control pipeline, as the input
+// task runs them, see session.hpp for the format. Calibration is fixed from
+// the sessions, auto-tare is not modelled, and keys are scored on their duty
+// cycles rather than the modulated key presses.
+//
+//   tuner [options] session.csv...
+//     --grid N             N values of each swept setting (default 5)
+//     --random N           N uniformly random candidates instead of a grid
+//     --seed S             Random search seed (default 1)
+//     --range NAME=LO:HI   Override the range swept for one setting
+//     --threads N          Worker threads (default all cores)
+//     --top N              Rows in the ranked table (default 10)
+//     --base FILE          Settings blob the unswept settings come from
+//     --output FILE        Write the best candidate as a settings blob
+//     --rest X             Report level counted as at rest (default 0.05)
+//     --intent X           Report level counted as a deliberate input (default 0.3)
+//     --chatter-ms X       Key states shorter than this are chatter (default 100)
+//     --chatter-weight X   Score per chattered state per minute (default 10)
+//     --false-weight X     Score per percent of rest time with a key pressed (default 10)
+//     --delay-weight X     Score per millisecond of mean delay (default 1)
+//     --miss-weight X      Score per missed input (default 1000)
+//
+// A settings blob is the raw control_settings_t stored in the config flash
+// sector. Its fields are all fixed width, so host and firmware layouts match.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "score.hpp"
+#include "session.hpp"
+#include "work_stealing_pool.hpp"
+
+namespace {
+
+struct tuner_dimension {
+    const char* name;
+    float control_settings_t::* field;
+    float low;
+    float high;
+};
+
+// Swept settings and their default ranges
+tuner_dimension tuner_dimensions[] = {
+    {"pedal_deadzone", &control_settings_t::pedal_deadzone, 0.0f, 0.25f},
+    {"tiller_deadzone", &control_settings_t::tiller_deadzone, 0.0f, 0.25f},
+    {"tiller_max_turn_threshold", &control_settings_t::tiller_max_turn_threshold, 0.4f, 0.9f},
+    {"tiller_handbrake_threshold_begin", &control_settings_t::tiller_handbrake_threshold_begin, 0.6f, 0.95f},
+    {"tiller_handbrake_threshold_end", &control_settings_t::tiller_handbrake_threshold_end, 0.7f, 1.0f},
+};
+constexpr size_t tuner_n_dimensions = std::size(tuner_dimensions);
+
+// The firmware defaults from the input task
+control_settings_t tuner_default_settings() {
+    filter_config_t pedal_filter = {};
+    pedal_filter.type = FILTER_EMA;
+    pedal_filter.ema_alpha_q16 = 16384;
+    filter_config_t tiller_filter = {};
+    tiller_filter.type = FILTER_BIQUAD_LOW_PASS;
+    tiller_filter.biquad_cutoff_mhz = 8000;
+    tiller_filter.biquad_sample_rate_hz = 40;
+
+    control_settings_t settings = {};
+    settings.pedal_deadzone = 0.07f;
+    settings.tiller_deadzone = 0.07f;
+    settings.tiller_max_turn_threshold = 0.65f;
+    settings.tiller_handbrake_threshold_begin = 0.8f;
+    settings.tiller_handbrake_threshold_end = 0.9f;
+    settings.tiller_prediction_horizon_us = 10000;
+    settings.accelerator_filter = pedal_filter;
+    settings.brake_filter = pedal_filter;
+    settings.clutch_filter = pedal_filter;
+    settings.left_tiller_filter = tiller_filter;
+    settings.right_tiller_filter = tiller_filter;
+    settings.pedal_response_curve.type = RESPONSE_CURVE_LINEAR;
+    settings.tiller_response_curve.type = RESPONSE_CURVE_LINEAR;
+    settings.tiller_auto_tare = {.window_us = 2000000, .max_deviation = 2000, .correction_q16 = 6554};
+    settings.auto_tare_save_interval_ms = 10 * 60 * 1000;
+    return settings;
+}
+
+// Settings the firmware would accept and that make sense on the rig
+bool tuner_candidate_valid(const control_settings_t& settings) {
+    return settings.tiller_deadzone < settings.tiller_max_turn_threshold &&
+           settings.tiller_max_turn_threshold <= settings.tiller_handbrake_threshold_begin &&
+           settings.tiller_handbrake_threshold_begin <= settings.tiller_handbrake_threshold_end;
+}
+
+std::vector<control_settings_t> tuner_grid(const control_settings_t& base, uint32_t steps) {
+    std::vector<control_settings_t> candidates;
+    std::vector<uint32_t> index(tuner_n_dimensions, 0);
+    while (true) {
+        control_settings_t candidate = base;
+        for (size_t d = 0; d < tuner_n_dimensions; d++) {
+            const tuner_dimension& dimension = tuner_dimensions[d];
+            const float t = steps > 1 ? static_cast<float>(index[d]) / static_cast<float>(steps - 1) : 0.5f;
+            candidate.*dimension.field = dimension.low + t * (dimension.high - dimension.low);
+        }
+        if (tuner_candidate_valid(candidate)) {
+            candidates.push_back(candidate);
+        }
+
+        // Odometer increment
+        size_t d = 0;
+        while (d < tuner_n_dimensions && ++index[d] == steps) {
+            index[d++] = 0;
+        }
+        if (d == tuner_n_dimensions) {
+            return candidates;
+        }
+    }
+}
+
+std::vector<control_settings_t> tuner_random(const control_settings_t& base, uint32_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<control_settings_t> candidates;
+    candidates.reserve(n);
+    while (candidates.size() < n) {
+        control_settings_t candidate = base;
+        for (const tuner_dimension& dimension : tuner_dimensions) {
+            std::uniform_real_distribution<float> distribution(dimension.low, dimension.high);
+            candidate.*dimension.field = distribution(rng);
+        }
+        if (tuner_candidate_valid(candidate)) {
+            candidates.push_back(candidate);
+        }
+    }
+    return candidates;
+}
+
+bool tuner_read_blob(const std::string& path, control_settings_t& settings) {
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<char> blob((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!file.is_open() || sizeof(control_settings_t) != blob.size()) {
+        std::fprintf(stderr, "%s: expected a %zu byte settings blob\n", path.c_str(), sizeof(control_settings_t));
+        return false;
+    }
+    std::memcpy(&settings, blob.data(), sizeof(control_settings_t));
+    return true;
+}
+
+bool tuner_write_blob(const std::string& path, const control_settings_t& settings) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&settings), sizeof(control_settings_t));
+    if (!file) {
+        std::fprintf(stderr, "%s: cannot write settings blob\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool tuner_set_range(std::string_view argument) {
+    const size_t equals = argument.find('=');
+    const size_t colon = argument.find(':', equals);
+    if (std::string_view::npos == equals || std::string_view::npos == colon) {
+        return false;
+    }
+    const std::string_view name = argument.substr(0, equals);
+    for (tuner_dimension& dimension : tuner_dimensions) {
+        if (name == dimension.name) {
+            const std::string low(argument.substr(equals + 1, colon - equals - 1));
+            const std::string high(argument.substr(colon + 1));
+            dimension.low = std::strtof(low.c_str(), nullptr);
+            dimension.high = std::strtof(high.c_str(), nullptr);
+            return dimension.low <= dimension.high;
+        }
+    }
+    return false;
+}
+
+void tuner_usage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [--grid N | --random N] [--seed S] [--range NAME=LO:HI] [--threads N] [--top N]\n"
+                 "       [--base FILE] [--output FILE] [--rest X] [--intent X] [--chatter-ms X]\n"
+                 "       [--chatter-weight X] [--false-weight X] [--delay-weight X] [--miss-weight X] session.csv...\n",
+                 program);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    uint32_t grid_steps = 5;
+    uint32_t random_candidates = 0;
+    uint32_t seed = 1;
+    unsigned n_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t top = 10;
+    std::string base_path;
+    std::string output_path;
+    float rest_level = 0.05f;
+    float intent_level = 0.3f;
+    double chatter_ms = 100.0;
+    tuner_score_config score_config = {};
+    score_config.chatter_weight = 10.0;
+    score_config.false_weight = 10.0;
+    score_config.delay_weight = 1.0;
+    score_config.miss_weight = 1000.0;
+    std::vector<std::string> session_paths;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view argument = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (!argument.starts_with("--")) {
+            session_paths.emplace_back(argument);
+        } else if (!has_value) {
+            tuner_usage(argv[0]);
+            return EXIT_FAILURE;
+        } else if ("--grid" == argument) {
+            grid_steps = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        } else if ("--random" == argument) {
+            random_candidates = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        } else if ("--seed" == argument) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        } else if ("--range" == argument) {
+            if (!tuner_set_range(argv[++i])) {
+                std::fprintf(stderr, "bad range: %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if ("--threads" == argument) {
+            n_threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        } else if ("--top" == argument) {
+            top = std::strtoul(argv[++i], nullptr, 0);
+        } else if ("--base" == argument) {
+            base_path = argv[++i];
+        } else if ("--output" == argument) {
+            output_path = argv[++i];
+        } else if ("--rest" == argument) {
+            rest_level = std::strtof(argv[++i], nullptr);
+        } else if ("--intent" == argument) {
+            intent_level = std::strtof(argv[++i], nullptr);
+        } else if ("--chatter-ms" == argument) {
+            chatter_ms = std::strtod(argv[++i], nullptr);
+        } else if ("--chatter-weight" == argument) {
+            score_config.chatter_weight = std::strtod(argv[++i], nullptr);
+        } else if ("--false-weight" == argument) {
+            score_config.false_weight = std::strtod(argv[++i], nullptr);
+        } else if ("--delay-weight" == argument) {
+            score_config.delay_weight = std::strtod(argv[++i], nullptr);
+        } else if ("--miss-weight" == argument) {
+            score_config.miss_weight = std::strtod(argv[++i], nullptr);
+        } else {
+            tuner_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (session_paths.empty() || 0 == grid_steps) {
+        tuner_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    score_config.rest_level = q16_from_float(rest_level);
+    score_config.intent_level = q16_from_float(intent_level);
+    score_config.chatter_us = static_cast<uint32_t>(chatter_ms * 1000.0);
+
+    control_settings_t base = tuner_default_settings();
+    if (!base_path.empty() && !tuner_read_blob(base_path, base)) {
+        return EXIT_FAILURE;
+    }
+
+    // Sessions
+    std::vector<tuner_session> sessions(session_paths.size());
+    for (size_t i = 0; i < sessions.size(); i++) {
+        std::string error;
+        if (!tuner_session_load(session_paths[i], sessions[i], error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    control_raw_report_t calibration_min;
+    control_raw_report_t calibration_max;
+    tuner_sessions_calibrate(sessions, calibration_min, calibration_max);
+    for (tuner_session& session : sessions) {
+        tuner_session_prepare(session, base, calibration_min, calibration_max);
+    }
+
+    // Candidates, the base settings are always scored so there is a reference
+    std::vector<control_settings_t> candidates =
+        0 != random_candidates ? tuner_random(base, random_candidates, seed) : tuner_grid(base, grid_steps);
+    candidates.insert(candidates.begin(), base);
+
+    std::vector<tuner_metrics> metrics(candidates.size());
+    work_stealing_pool pool(n_threads);
+    const auto start = std::chrono::steady_clock::now();
+    pool.run(candidates.size(), [&](size_t i) {
+        metrics[i] = tuner_score(sessions, candidates[i], calibration_min, calibration_max, score_config);
+    });
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Ranked table, ties keep candidate order so runs are repeatable
+    std::vector<size_t> ranking(candidates.size());
+    std::iota(ranking.begin(), ranking.end(), 0);
+    std::stable_sort(ranking.begin(), ranking.end(),
+                     [&](size_t a, size_t b) { return metrics[a].score < metrics[b].score; });
+
+    std::printf("%zu candidates over %zu sessions on %u threads in %.2f s\n", candidates.size(), sessions.size(),
+                pool.size(), elapsed_s);
+    std::printf("calibration accelerator %d..%d left_tiller %d..%d right_tiller %d..%d\n\n",
+                calibration_min.accelerator, calibration_max.accelerator, calibration_min.left_tiller,
+                calibration_max.left_tiller, calibration_min.right_tiller, calibration_max.right_tiller);
+    std::printf(
+        "rank  candidate  score      chatter/min  false_%%  delay_ms  misses  pedal_dz  tiller_dz  max_turn  hb_begin  "
+        "hb_end\n");
+    for (size_t rank = 0; rank < std::min(top, ranking.size()); rank++) {
+        const size_t i = ranking[rank];
+        const control_settings_t& settings = candidates[i];
+        std::printf("%4zu  %9zu  %9.3f  %11.3f  %7.2f  %8.2f  %6llu  %8.3f  %9.3f  %8.3f  %8.3f  %6.3f%s\n", rank + 1,
+                    i, metrics[i].score, metrics[i].chatter_per_minute(), metrics[i].false_percent(),
+                    metrics[i].mean_delay_ms(),
+                    static_cast<unsigned long long>(metrics[i].misses), settings.pedal_deadzone,
+                    settings.tiller_deadzone, settings.tiller_max_turn_threshold,
+                    settings.tiller_handbrake_threshold_begin, settings.tiller_handbrake_threshold_end,
+                    0 == i ? "  (base)" : "");
+    }
+
+    const control_settings_t& best = candidates[ranking.front()];
+    std::printf("\nbest settings\n");
+    for (const tuner_dimension& dimension : tuner_dimensions) {
+        std::printf("  .%s = %.4f\n", dimension.name, best.*dimension.field);
+    }
+    if (!output_path.empty()) {
+        if (!tuner_write_blob(output_path, best)) {
+            return EXIT_FAILURE;
+        }
+        std::printf("wrote %zu byte settings blob to %s\n", sizeof(control_settings_t), output_path.c_str());
+    }
+    return EXIT_SUCCESS;
+}
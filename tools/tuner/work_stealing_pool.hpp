@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Runs a fixed set of independent tasks over a pool of threads. Each worker
+// owns a deque of task indices and works from its back, and an idle worker
+// steals from the front of the others, so uneven task costs still keep every
+// core busy until the end.
+class work_stealing_pool {
+   public:
+    explicit work_stealing_pool(unsigned n_threads) : queues_(std::max(1u, n_threads)) {}
+
+    unsigned size() const { return static_cast<unsigned>(queues_.size()); }
+
+    // Calls `task(index)` once for each index below `n_tasks`, returning when all are done
+    template <typename Task>
+    void run(size_t n_tasks, Task&& task) {
+        // Contiguous blocks keep neighbouring tasks on one worker until stolen
+        const size_t n_workers = queues_.size();
+        for (size_t worker = 0; worker < n_workers; worker++) {
+            const size_t begin = n_tasks * worker / n_workers;
+            const size_t end = n_tasks * (worker + 1) / n_workers;
+            for (size_t i = begin; i < end; i++) {
+                queues_[worker].tasks.push_back(i);
+            }
+        }
+
+        // Nothing is queued once the run starts, so empty everywhere means done
+        std::vector<std::jthread> workers;
+        workers.reserve(n_workers);
+        for (size_t worker = 0; worker < n_workers; worker++) {
+            workers.emplace_back([this, worker, &task] {
+                while (const std::optional<size_t> index = next(worker)) {
+                    task(*index);
+                }
+            });
+        }
+    }
+
+   private:
+    struct queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    std::optional<size_t> next(size_t worker) {
+        {
+            queue& own = queues_[worker];
+            std::lock_guard lock(own.mutex);
+            if (!own.tasks.empty()) {
+                const size_t index = own.tasks.back();
+                own.tasks.pop_back();
+                return index;
+            }
+        }
+
+        // Steal, starting from the next worker along so thieves spread out
+        for (size_t offset = 1; offset < queues_.size(); offset++) {
+            queue& victim = queues_[(worker + offset) % queues_.size()];
+            std::lock_guard lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                const size_t index = victim.tasks.front();
+                victim.tasks.pop_front();
+                return index;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::vector<queue> queues_;
+};